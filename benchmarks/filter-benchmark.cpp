@@ -0,0 +1,412 @@
+#include "wallpablur/config/config.hpp"
+#include "wallpablur/egl/context.hpp"
+#include "wallpablur/exception.hpp"
+#include "wallpablur/image.hpp"
+#include "wallpablur/texture-generator.hpp"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <logcerr/log.hpp>
+
+#include <getopt.h>
+
+
+
+namespace {
+  constexpr std::string_view help_text =
+R"(Usage: {0} [OPTIONS...]
+
+Runs the texture generator on an offscreen context over a matrix of output sizes and
+filters and prints the results as JSON.
+
+Available options:
+  -h, --help                  show this help and exit
+  -V, --verbose               enable verbose logging (use twice for debug output)
+
+  -i, --image <path>          use the image at <path> instead of a generated one
+  -r, --repetitions <n>       measure every combination <n> times (default: 3)
+  -s, --sizes <list>          comma separated subset of 1080p,1440p,4k,8k
+)";
+
+
+
+  struct output_size {
+    std::string_view name;
+    vec2<uint32_t>   size;
+  };
+
+  constexpr std::array output_sizes {
+    output_size{"1080p", {1920, 1080}},
+    output_size{"1440p", {2560, 1440}},
+    output_size{"4k",    {3840, 2160}},
+    output_size{"8k",    {7680, 4320}},
+  };
+
+
+
+  struct filter_config {
+    std::string                 name;
+    std::vector<config::filter> filters;
+  };
+
+  [[nodiscard]] config::box_blur_filter box_blur(uint32_t radius, unsigned int iterations) {
+    config::box_blur_filter filter;
+    filter.size       = vec2<uint32_t>{radius, radius};
+    filter.iterations = iterations;
+    return filter;
+  }
+
+  [[nodiscard]] std::vector<filter_config> filter_configs() {
+    return {
+      {"rescale",               {}},
+      {"invert",                {config::invert_filter{}}},
+      {"box-blur-16x1",         {box_blur(16, 1)}},
+      {"box-blur-64x2",         {box_blur(64, 2)}},
+      {"box-blur-256x4",        {box_blur(256, 4)}},
+      {"box-blur-64x2+invert",  {box_blur(64, 2), config::invert_filter{}}},
+    };
+  }
+
+
+
+
+
+  struct benchmark_args {
+    int                                  verbose    {0};
+    unsigned int                         repetitions{3};
+    std::optional<std::filesystem::path> image;
+    std::vector<output_size>             sizes{output_sizes.begin(), output_sizes.end()};
+  };
+
+
+
+  [[nodiscard]] std::vector<output_size> sizes_from_string(std::string_view input) {
+    std::vector<output_size> sizes;
+
+    while (!input.empty()) {
+      auto name = input.substr(0, input.find(','));
+      input.remove_prefix(std::min(input.size(), name.size() + 1));
+
+      auto it = std::ranges::find(output_sizes, name, &output_size::name);
+      if (it == output_sizes.end()) {
+        throw exception{logcerr::format("unknown output size \"{}\"", name)};
+      }
+      sizes.emplace_back(*it);
+    }
+
+    return sizes;
+  }
+
+
+
+  [[nodiscard]] std::optional<benchmark_args> parse_args(std::span<char*> arg) {
+    //NOLINTBEGIN(modernize-use-designated-initializers)
+    static const std::array long_options = {
+      option{"help",        no_argument,       nullptr, 'h'},
+      option{"verbose",     no_argument,       nullptr, 'V'},
+      option{"image",       required_argument, nullptr, 'i'},
+      option{"repetitions", required_argument, nullptr, 'r'},
+      option{"sizes",       required_argument, nullptr, 's'},
+      option{nullptr,       0,                 nullptr,  0 }
+    };
+    //NOLINTEND(modernize-use-designated-initializers)
+
+    benchmark_args args;
+    int c{0};
+
+    while ((c = getopt_long(arg.size(), arg.data(),
+            "hVi:r:s:", long_options.data(), nullptr)) != -1) {
+      switch (c) {
+        case 'h':
+          logcerr::print_raw_sync(std::cout, logcerr::format(help_text,
+                std::filesystem::path{arg[0]}.filename().string()));
+          return {};
+
+        case 'V': args.verbose++; break;
+
+        case 'i': args.image       = optarg; break;
+        case 'r': args.repetitions = std::max(1, std::stoi(optarg)); break;
+        case 's': args.sizes       = sizes_from_string(optarg); break;
+
+        default: break;
+      }
+    }
+
+    return args;
+  }
+
+
+
+
+
+  // smooth gradients with some noise, so that neither the blur nor the rescale can take
+  // shortcuts on uniform areas
+  [[nodiscard]] std::filesystem::path generate_image(vec2<uint32_t> size) {
+    auto path = std::filesystem::temp_directory_path() / "wallpablur-benchmark.ff";
+
+    auto stride = static_cast<size_t>(size.x()) * 4;
+    auto pixels = std::make_shared<std::vector<std::byte>>(stride * size.y());
+
+    uint32_t state{0x12345678};
+
+    for (uint32_t y = 0; y < size.y(); ++y) {
+      for (uint32_t x = 0; x < size.x(); ++x) {
+        state = state * 1664525u + 1013904223u;
+        auto noise = (state >> 24u) & 0x1fu;
+
+        auto* pixel = pixels->data() + y * stride + x * 4;
+        pixel[0] = static_cast<std::byte>(x * 255 / size.x() ^ noise);
+        pixel[1] = static_cast<std::byte>(y * 255 / size.y() ^ noise);
+        pixel[2] = static_cast<std::byte>((x + y) % 256);
+        pixel[3] = std::byte{0xff};
+      }
+    }
+
+    write_farbfeld(path, image{
+      .width   = static_cast<GLsizei>(size.x()),
+      .height  = static_cast<GLsizei>(size.y()),
+      .stride  = stride,
+      .format  = gl::texture::format::rgba8,
+      .pixels  = *pixels,
+      .storage = pixels,
+
+      .original_size = size
+    });
+
+    return path;
+  }
+
+
+
+
+
+  class gpu_timer {
+    public:
+      gpu_timer(const gpu_timer&) = delete;
+      gpu_timer(gpu_timer&&)      = delete;
+      gpu_timer& operator=(const gpu_timer&) = delete;
+      gpu_timer& operator=(gpu_timer&&)      = delete;
+
+      gpu_timer() {
+        if (supported()) {
+          glGenQueries(1, &query_);
+        }
+      }
+
+      ~gpu_timer() {
+        if (query_ != 0) {
+          glDeleteQueries(1, &query_);
+        }
+      }
+
+      void begin() const {
+        if (query_ != 0) {
+          glBeginQuery(GL_TIME_ELAPSED, query_);
+        }
+      }
+
+      [[nodiscard]] std::optional<double> end() const {
+        if (query_ == 0) {
+          return {};
+        }
+
+        glEndQuery(GL_TIME_ELAPSED);
+
+        GLuint64 elapsed{0};
+        glGetQueryObjectui64v(query_, GL_QUERY_RESULT, &elapsed);
+
+        return static_cast<double>(elapsed) / 1e6;
+      }
+
+      [[nodiscard]] static bool supported() {
+        return epoxy_gl_version() >= 33 || epoxy_has_gl_extension("GL_ARB_timer_query");
+      }
+
+
+
+    private:
+      GLuint query_{0};
+  };
+
+
+
+  struct measurement {
+    std::vector<double> wall_ms;
+    std::vector<double> gpu_ms;
+    size_t              peak_texture_bytes{0};
+  };
+
+
+
+  [[nodiscard]] measurement run(
+      const texture_generator& generator,
+      const wayland::geometry& geometry,
+      const config::brush&     brush,
+      unsigned int             repetitions
+  ) {
+    measurement output;
+    gpu_timer   timer;
+
+    // compiles the shaders and decodes the source image
+    std::ignore = generator.generate(geometry, brush);
+
+    for (unsigned int i = 0; i < repetitions; ++i) {
+      generator.release_render_targets();
+      gl::texture::reset_peak_memory();
+
+      auto start = std::chrono::steady_clock::now();
+      timer.begin();
+
+      auto texture = generator.generate(geometry, brush);
+
+      auto gpu = timer.end();
+      glFinish();
+
+      output.wall_ms.emplace_back(std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now() - start).count());
+
+      if (gpu) {
+        output.gpu_ms.emplace_back(*gpu);
+      }
+
+      output.peak_texture_bytes = std::max(output.peak_texture_bytes,
+          gl::texture::allocated_memory().peak);
+    }
+
+    return output;
+  }
+
+
+
+
+
+  [[nodiscard]] std::string statistics(std::vector<double> values) {
+    if (values.empty()) {
+      return "null";
+    }
+
+    std::ranges::sort(values);
+
+    return logcerr::format(R"({{"min": {:.3f}, "median": {:.3f}, "max": {:.3f}}})",
+        values.front(), values[values.size() / 2], values.back());
+  }
+
+
+
+  [[nodiscard]] std::string escape(std::string_view input) {
+    std::string output;
+
+    for (auto c: input) {
+      if (c == '"' || c == '\\') {
+        output += '\\';
+      }
+      output += c;
+    }
+
+    return output;
+  }
+
+
+
+  void init_logcerr(int verbose) {
+    if (verbose == 0) {
+      logcerr::output_level(logcerr::severity::warning);
+    } else if (verbose == 1) {
+      logcerr::output_level(logcerr::severity::verbose);
+    } else {
+      logcerr::output_level(logcerr::severity::debug);
+    }
+  }
+}
+
+
+
+
+
+int main(int argc, char** argv) {
+  std::span arg{argv, static_cast<size_t>(argc)};
+
+  try {
+    auto args = parse_args(arg);
+    if (!args) {
+      return EXIT_SUCCESS;
+    }
+
+    init_logcerr(args->verbose);
+
+    auto context = std::make_shared<egl::context>(egl::context::headless(1, 1));
+    context->make_current();
+
+    texture_generator generator{context};
+
+    std::optional<std::filesystem::path> generated;
+    if (!args->image) {
+      generated = generate_image({3840, 2160});
+    }
+
+    config::brush brush;
+    brush.fgraph = config::filter_graph{
+      .path         = args->image.value_or(generated.value_or("")),
+      .distribution = {},
+      .filters      = {}
+    };
+
+    auto backend = config::global_config().filter_backend() == config::filter_backend::gl
+      ? "gl" : "cpu";
+
+    std::cout << logcerr::format(
+        "{{\n  \"renderer\": \"{}\",\n  \"backend\": \"{}\",\n"
+        "  \"repetitions\": {},\n  \"results\": [",
+        escape(reinterpret_cast<const char*>(glGetString(GL_RENDERER))), // NOLINT
+        backend, args->repetitions);
+
+    bool first{true};
+
+    for (const auto& size: args->sizes) {
+      wayland::geometry geometry;
+      geometry.physical_size(size.size);
+
+      for (const auto& filters: filter_configs()) {
+        brush.fgraph->filters = filters.filters;
+
+        logcerr::verbose("running {} at {}", filters.name, size.name);
+
+        auto result = run(generator, geometry, brush, args->repetitions);
+
+        std::cout << logcerr::format(
+            "{}\n    {{\"size\": \"{}\", \"width\": {}, \"height\": {}, \"filters\": \"{}\", "
+            "\"wall_ms\": {}, \"gpu_ms\": {}, \"peak_texture_bytes\": {}}}",
+            first ? "" : ",", size.name, size.size.x(), size.size.y(), filters.name,
+            statistics(result.wall_ms), statistics(result.gpu_ms),
+            result.peak_texture_bytes);
+        std::cout.flush();
+
+        first = false;
+      }
+    }
+
+    std::cout << "\n  ]\n}\n";
+
+    if (generated) {
+      std::filesystem::remove(*generated);
+    }
+
+  } catch (std::exception& ex) {
+    logcerr::error(ex.what());
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
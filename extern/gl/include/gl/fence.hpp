@@ -0,0 +1,35 @@
+#ifndef GL_FENCE_HPP_INCLUDED
+#define GL_FENCE_HPP_INCLUDED
+
+#include <chrono>
+#include <memory>
+#include <type_traits>
+
+#include <epoxy/gl.h>
+
+
+
+namespace gl {
+
+class fence {
+  public:
+    fence();
+
+
+
+    [[nodiscard]] bool client_wait(std::chrono::nanoseconds) const;
+    void               wait() const;
+
+
+
+  private:
+    struct deleter {
+      void operator()(GLsync s) { glDeleteSync(s); }
+    };
+
+    std::unique_ptr<std::remove_pointer_t<GLsync>, deleter> sync_;
+};
+
+}
+
+#endif // GL_FENCE_HPP_INCLUDED
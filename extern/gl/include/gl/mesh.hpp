@@ -15,6 +15,7 @@ class mesh {
 
 
     void draw() const;
+    void draw_instanced(GLsizei count, GLuint first_instance = 0) const;
 
 
 
@@ -48,6 +48,8 @@ class object_name {
 
     [[nodiscard]] GLuint get() const { return name_; }
 
+    [[nodiscard]] FNC& deleter() { return deleter_; }
+
 
 
   private:
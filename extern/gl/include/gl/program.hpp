@@ -3,6 +3,7 @@
 
 #include "gl/object-name.hpp"
 
+#include <filesystem>
 #include <optional>
 #include <span>
 #include <stdexcept>
@@ -16,6 +17,7 @@ namespace gl {
 enum class shader_type : GLenum {
   vertex   = GL_VERTEX_SHADER,
   fragment = GL_FRAGMENT_SHADER,
+  compute  = GL_COMPUTE_SHADER,
 
   linking  = 0
 };
@@ -53,6 +55,10 @@ class program_error : public std::runtime_error {
 class program {
   public:
     program(std::string_view, std::string_view);
+    explicit program(std::string_view);
+
+    // linked programs are stored in and restored from this directory, if set
+    static void binary_cache_directory(std::optional<std::filesystem::path>);
 
 
 
@@ -0,0 +1,48 @@
+#ifndef GL_SAMPLER_HPP_INCLUDED
+#define GL_SAMPLER_HPP_INCLUDED
+
+#include "gl/object-name.hpp"
+
+
+
+namespace gl {
+
+// sampling parameters which override those of the bound texture, without changing the
+// texture itself (which other contexts may be sampling at the same time)
+class sampler {
+  public:
+    sampler(GLenum wrap, GLenum filter);
+
+
+
+    class sampler_lock {
+      public:
+        sampler_lock(const sampler_lock&) = delete;
+        sampler_lock(sampler_lock&&) noexcept;
+        sampler_lock& operator=(const sampler_lock&) = delete;
+        sampler_lock& operator=(sampler_lock&&) noexcept;
+
+        explicit sampler_lock(GLuint unit) : unit_{unit} {}
+        ~sampler_lock();
+
+      private:
+        GLuint unit_;
+        bool   needs_unlock_{true};
+    };
+
+    // bound to texture unit `unit` until the lock goes out of scope
+    [[nodiscard]] sampler_lock bind(GLuint unit = 0) const;
+
+
+
+  private:
+    struct deleter {
+      void operator()(GLuint s) { glDeleteSamplers(1, &s); }
+    };
+
+    object_name<deleter> sampler_;
+};
+
+}
+
+#endif // GL_SAMPLER_HPP_INCLUDED
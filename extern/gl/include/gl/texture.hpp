@@ -4,6 +4,7 @@
 #include "gl/object-name.hpp"
 
 #include <span>
+#include <vector>
 
 
 
@@ -21,6 +22,7 @@ class texture {
     enum class format {
       rgba8,
       rgb8,
+      rgba16_be,
     };
 
 
@@ -28,7 +30,14 @@ class texture {
     texture();
     texture(texture_size, format = format::rgba8);
     texture(GLsizei, GLsizei, format = format::rgba8);
-    texture(GLsizei, GLsizei, std::span<const std::byte>, format = format::rgba8);
+
+    // `levels` > 1 generates a mipmap chain of that length from `data`
+    texture(GLsizei, GLsizei, std::span<const std::byte>, format = format::rgba8,
+        GLsizei levels = 1);
+
+    // storage can not be resized later, contents are provided through update()
+    [[nodiscard]] static texture immutable(texture_size, format = format::rgba8,
+        GLsizei levels = 1);
 
 
 
@@ -42,13 +51,39 @@ class texture {
 
 
 
+    [[nodiscard]] texture_size           size()                             const;
+    [[nodiscard]] std::vector<std::byte> download(format = format::rgba8) const;
+
+    // `pixels` is an offset if a pixel unpack buffer is bound
+    void update(GLint, texture_size, size_t, const void*, format = format::rgba8) const;
+
+    // fills all levels but the first from the contents of the first one
+    void generate_mipmaps() const;
+
+
+
+    struct memory_usage {
+      size_t current{0};
+      size_t peak   {0};
+    };
+
+    // storage allocated by all textures which are alive, shared by all contexts
+    [[nodiscard]] static memory_usage allocated_memory();
+    static void reset_peak_memory();
+
+
+
   private:
     struct deleter {
-      void operator()(GLuint t) { glDeleteTextures(1, &t); }
+      size_t bytes{0};
+
+      void operator()(GLuint) const;
     };
 
     object_name<deleter> texture_;
 
+    void track_storage(texture_size, format, GLsizei levels = 1);
+
 
     static void bind_tex(GLuint t) {
       glBindTexture(GL_TEXTURE_2D, t);
@@ -59,6 +94,12 @@ class texture {
 
 [[nodiscard]] texture_size active_texture_size();
 
+// number of mipmap levels with storage, at least one
+[[nodiscard]] GLsizei active_texture_levels();
+
+// number of levels needed to reduce `size` by `factor` (rounded down to a power of two)
+[[nodiscard]] GLsizei mipmap_levels(texture_size size, float factor);
+
 }
 
 #endif // GL_TEXTURE_HPP_INCLUDED
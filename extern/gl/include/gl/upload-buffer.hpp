@@ -0,0 +1,49 @@
+#ifndef GL_UPLOAD_BUFFER_HPP_INCLUDED
+#define GL_UPLOAD_BUFFER_HPP_INCLUDED
+
+#include "gl/fence.hpp"
+#include "gl/object-name.hpp"
+#include "gl/texture.hpp"
+
+#include <optional>
+#include <span>
+
+
+
+namespace gl {
+
+// persistently mapped pixel unpack buffer, pixels written to data() can be uploaded
+// without being copied by the driver first
+class upload_buffer {
+  public:
+    explicit upload_buffer(size_t);
+
+
+
+    [[nodiscard]] std::span<std::byte> data() const { return mapping_; }
+    [[nodiscard]] size_t               size() const { return mapping_.size(); }
+
+    // copies `rows` starting at `first_row`, stored with `stride` bytes per row
+    void upload(const texture&, GLint first_row, texture_size rows, size_t stride,
+        texture::format = texture::format::rgba8) const;
+
+    // data() may be written to again once all uploads issued so far have completed
+    void finish();
+    void wait() const;
+
+
+
+  private:
+    struct deleter {
+      void operator()(GLuint b) { glDeleteBuffers(1, &b); }
+    };
+
+    object_name<deleter> buffer_;
+    std::span<std::byte> mapping_;
+
+    std::optional<fence> fence_;
+};
+
+}
+
+#endif // GL_UPLOAD_BUFFER_HPP_INCLUDED
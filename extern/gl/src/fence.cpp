@@ -0,0 +1,36 @@
+#include "gl/fence.hpp"
+
+#include <stdexcept>
+
+
+
+gl::fence::fence() :
+  sync_{glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0)}
+{
+  if (!sync_) {
+    throw std::runtime_error{"unable to create fence sync object"};
+  }
+}
+
+
+
+bool gl::fence::client_wait(std::chrono::nanoseconds timeout) const {
+  switch (glClientWaitSync(sync_.get(), GL_SYNC_FLUSH_COMMANDS_BIT, timeout.count())) {
+    case GL_ALREADY_SIGNALED:
+    case GL_CONDITION_SATISFIED:
+      return true;
+
+    case GL_TIMEOUT_EXPIRED:
+      return false;
+
+    case GL_WAIT_FAILED:
+    default:
+      throw std::runtime_error{"unable to wait for fence sync object"};
+  }
+}
+
+
+
+void gl::fence::wait() const {
+  glWaitSync(sync_.get(), 0, GL_TIMEOUT_IGNORED);
+}
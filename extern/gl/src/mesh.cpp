@@ -25,6 +25,14 @@ void gl::mesh::draw() const {
 
 
 
+void gl::mesh::draw_instanced(GLsizei count, GLuint first_instance) const {
+  glBindVertexArray(vao_.get());
+  glDrawElementsInstancedBaseInstance(GL_TRIANGLES, element_count_, GL_UNSIGNED_SHORT,
+      nullptr, count, first_instance);
+}
+
+
+
 
 
 size_t gl::mesh::get_element_count(GLuint ibo) {
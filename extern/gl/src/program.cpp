@@ -1,7 +1,17 @@
 #include "gl/program.hpp"
 
+#include <array>
 #include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <format>
+#include <fstream>
+#include <mutex>
 #include <stdexcept>
+#include <thread>
+#include <tuple>
+#include <utility>
+#include <vector>
 
 
 
@@ -41,6 +51,7 @@ namespace {
     switch (type) {
       case gl::shader_type::vertex:
       case gl::shader_type::fragment:
+      case gl::shader_type::compute:
         return get_message(id, glGetShaderiv, glGetShaderInfoLog);
       case gl::shader_type::linking:
         return get_message(id, glGetProgramiv, glGetProgramInfoLog);
@@ -54,6 +65,7 @@ namespace {
     switch (type) {
       case gl::shader_type::vertex:   return "compile vertex shader";
       case gl::shader_type::fragment: return "compile fragment shader";
+      case gl::shader_type::compute:  return "compile compute shader";
       case gl::shader_type::linking:  return "link program";
     }
 
@@ -167,6 +179,7 @@ namespace {
     switch (type) {
       case gl::shader_type::vertex:
       case gl::shader_type::fragment:
+      case gl::shader_type::compute:
         if (!get_status(id, glGetShaderiv, GL_COMPILE_STATUS)) {
           throw gl::program_error{id, type, std::string{source}};
         }
@@ -215,9 +228,287 @@ namespace {
 
 
 
+namespace {
+  std::mutex                           binary_cache_mutex;
+  std::optional<std::filesystem::path> binary_cache_path;
+  bool                                 binary_cache_pruned{false};
+
+
+
+  [[nodiscard]] std::optional<std::filesystem::path> binary_cache_directory() {
+    std::lock_guard lock{binary_cache_mutex};
+    return binary_cache_path;
+  }
+
+
+
+  // true for the first caller after the directory has been set
+  [[nodiscard]] bool claim_binary_cache_pruning() {
+    std::lock_guard lock{binary_cache_mutex};
+    return !std::exchange(binary_cache_pruned, true);
+  }
+
+
+
+  [[nodiscard]] bool binary_cache_supported() {
+    if (epoxy_gl_version() < 41 && !epoxy_has_gl_extension("GL_ARB_get_program_binary")) {
+      return false;
+    }
+
+    GLint formats{0};
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+    return formats > 0;
+  }
+
+
+
+  [[nodiscard]] uint64_t fnv1a(std::string_view input) {
+    uint64_t hash{0xcbf29ce484222325};
+
+    for (auto c: input) {
+      hash ^= static_cast<uint8_t>(c);
+      hash *= 0x100000001b3;
+    }
+
+    return hash;
+  }
+
+
+
+  [[nodiscard]] std::string_view gl_string(GLenum name) {
+    const auto* value = reinterpret_cast<const char*>(glGetString(name)); // NOLINT
+    return value != nullptr ? value : "";
+  }
+
+
+
+  [[nodiscard]] std::string driver_key() {
+    return std::format("{}\n{}\n{}", gl_string(GL_VENDOR), gl_string(GL_RENDERER),
+        gl_string(GL_VERSION));
+  }
+
+
+
+  // binaries are only valid for the exact same driver
+  [[nodiscard]] std::string binary_key(std::span<const std::string_view> sources) {
+    auto key = driver_key();
+
+    for (auto source: sources) {
+      key += std::format("\n{:016x}:{}", fnv1a(source), source.size());
+    }
+
+    return key;
+  }
+
+
+
+  constexpr std::array<char, 8> binary_magic  {'G', 'L', 'P', 'R', 'O', 'G', 'B', 'N'};
+  constexpr uint32_t            binary_version{1};
+
+  template<typename T>
+  void write_value(std::ostream& out, T value) {
+    out.write(reinterpret_cast<const char*>(&value), sizeof(value)); // NOLINT
+  }
+
+  template<typename T>
+  [[nodiscard]] T read_value(std::istream& in) {
+    T value{};
+    in.read(reinterpret_cast<char*>(&value), sizeof(value)); // NOLINT
+    return value;
+  }
+
+
+
+  // binaries of a different driver are never loaded again, and binaries which have not
+  // been loaded for a while most likely belong to shaders which have changed since
+  void prune_binary_cache(const std::filesystem::path& directory) {
+    static constexpr std::chrono::days max_age{30};
+
+    auto driver = driver_key();
+    auto now    = std::filesystem::file_time_type::clock::now();
+
+    std::error_code ec;
+    for (std::filesystem::directory_iterator it{directory, ec}, end;
+         !ec && it != end; it.increment(ec)) {
+      if (it->path().extension() != ".bin") {
+        continue;
+      }
+
+      bool current{false};
+      {
+        std::ifstream input{it->path(), std::ios::binary};
+
+        auto magic      = read_value<std::array<char, 8>>(input);
+        auto version    = read_value<uint32_t>(input);
+        std::ignore     = read_value<GLenum>(input);
+        auto key_length = read_value<uint64_t>(input);
+
+        if (input && magic == binary_magic && version == binary_version
+            && key_length >= driver.size()) {
+          std::string key(driver.size(), '\0');
+          input.read(key.data(), static_cast<std::streamsize>(key.size()));
+          current = input && key == driver;
+        }
+      }
+
+      std::error_code time_ec;
+      auto last_used = it->last_write_time(time_ec);
+
+      if (!current || time_ec || now - last_used > max_age) {
+        std::error_code remove_ec;
+        std::filesystem::remove(it->path(), remove_ec);
+      }
+    }
+  }
+
+
+
+  class binary_cache_entry {
+    public:
+      explicit binary_cache_entry(std::span<const std::string_view> sources) {
+        auto directory = binary_cache_directory();
+        if (!directory || !binary_cache_supported()) {
+          return;
+        }
+
+        if (claim_binary_cache_pruning()) {
+          prune_binary_cache(*directory);
+        }
+
+        key_  = binary_key(sources);
+        path_ = *directory / std::format("{:016x}.bin", fnv1a(key_));
+      }
+
+
+
+      [[nodiscard]] bool enabled() const { return !path_.empty(); }
+
+
+
+      [[nodiscard]] bool load(GLuint program) const {
+        if (!enabled()) {
+          return false;
+        }
+
+        std::ifstream input{path_, std::ios::binary};
+        if (!input) {
+          return false;
+        }
+
+        auto magic      = read_value<std::array<char, 8>>(input);
+        auto version    = read_value<uint32_t>(input);
+        auto format     = read_value<GLenum>(input);
+        auto key_length = read_value<uint64_t>(input);
+
+        if (!input || magic != binary_magic || version != binary_version ||
+            key_length != key_.size()) {
+          return false;
+        }
+
+        std::string key(key_length, '\0');
+        input.read(key.data(), static_cast<std::streamsize>(key_length));
+
+        auto binary_length = read_value<uint64_t>(input);
+        if (!input || key != key_) {
+          return false;
+        }
+
+        std::vector<char> binary(binary_length);
+        input.read(binary.data(), static_cast<std::streamsize>(binary_length));
+        if (!input) {
+          return false;
+        }
+
+        glProgramBinary(program, format, binary.data(), static_cast<GLsizei>(binary.size()));
+
+        if (!get_status(program, glGetProgramiv, GL_LINK_STATUS)) {
+          return false;
+        }
+
+        // the modification time tells the last use when pruning
+        std::error_code ec;
+        std::filesystem::last_write_time(path_,
+            std::filesystem::file_time_type::clock::now(), ec);
+
+        return true;
+      }
+
+
+
+      void store(GLuint program) const {
+        if (!enabled()) {
+          return;
+        }
+
+        GLint length{0};
+        glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+        if (length <= 0) {
+          return;
+        }
+
+        std::vector<char> binary(static_cast<size_t>(length));
+        GLenum format{0};
+        glGetProgramBinary(program, length, &length, &format, binary.data());
+        binary.resize(static_cast<size_t>(length));
+
+        // programs may be linked on several threads at once
+        auto tmp = path_;
+        tmp += std::format(".{:x}.tmp", std::hash<std::thread::id>{}(std::this_thread::get_id()));
+
+        std::error_code ec;
+        std::filesystem::create_directories(path_.parent_path(), ec);
+
+        {
+          std::ofstream output{tmp, std::ios::binary | std::ios::trunc};
+
+          output.write(binary_magic.data(), binary_magic.size());
+          write_value<uint32_t>(output, binary_version);
+          write_value<GLenum>(output, format);
+          write_value<uint64_t>(output, key_.size());
+          output.write(key_.data(), static_cast<std::streamsize>(key_.size()));
+          write_value<uint64_t>(output, binary.size());
+          output.write(binary.data(), static_cast<std::streamsize>(binary.size()));
+
+          if (!output.flush()) {
+            std::filesystem::remove(tmp, ec);
+            return;
+          }
+        }
+
+        std::filesystem::rename(tmp, path_, ec);
+        if (ec) {
+          std::filesystem::remove(tmp, ec);
+        }
+      }
+
+
+
+    private:
+      std::string           key_;
+      std::filesystem::path path_;
+  };
+}
+
+
+
+void gl::program::binary_cache_directory(std::optional<std::filesystem::path> directory) {
+  std::lock_guard lock{binary_cache_mutex};
+  binary_cache_path   = std::move(directory);
+  binary_cache_pruned = false;
+}
+
+
+
 gl::program::program(std::string_view vs, std::string_view fs) :
   program_{glCreateProgram()}
 {
+  std::array sources{vs, fs};
+  binary_cache_entry cache{sources};
+
+  if (cache.load(program_.get())) {
+    return;
+  }
+
   shader vertex  {gl::shader_type::vertex,   vs};
   glAttachShader(program_.get(), vertex.get());
 
@@ -225,12 +516,45 @@ gl::program::program(std::string_view vs, std::string_view fs) :
   glAttachShader(program_.get(), fragment.get());
 
 
+  if (cache.enabled()) {
+    glProgramParameteri(program_.get(), GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+  }
   glLinkProgram(program_.get());
 
   assert_object(program_.get(), gl::shader_type::linking, "");
 
   glDetachShader(program_.get(), vertex.get());
   glDetachShader(program_.get(), fragment.get());
+
+  cache.store(program_.get());
+}
+
+
+
+gl::program::program(std::string_view cs) :
+  program_{glCreateProgram()}
+{
+  std::array sources{cs};
+  binary_cache_entry cache{sources};
+
+  if (cache.load(program_.get())) {
+    return;
+  }
+
+  shader compute{gl::shader_type::compute, cs};
+  glAttachShader(program_.get(), compute.get());
+
+
+  if (cache.enabled()) {
+    glProgramParameteri(program_.get(), GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+  }
+  glLinkProgram(program_.get());
+
+  assert_object(program_.get(), gl::shader_type::linking, "");
+
+  glDetachShader(program_.get(), compute.get());
+
+  cache.store(program_.get());
 }
 
 
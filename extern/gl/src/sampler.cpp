@@ -0,0 +1,59 @@
+#include "gl/sampler.hpp"
+
+#include <utility>
+
+
+
+gl::sampler::sampler_lock::~sampler_lock() {
+  if (needs_unlock_) {
+    glBindSampler(unit_, 0);
+  }
+}
+
+
+
+gl::sampler::sampler_lock::sampler_lock(sampler_lock&& rhs) noexcept :
+  unit_        {rhs.unit_},
+  needs_unlock_{std::exchange(rhs.needs_unlock_, false)}
+{}
+
+
+
+gl::sampler::sampler_lock&
+gl::sampler::sampler_lock::operator=(sampler_lock&& rhs) noexcept
+{
+  std::swap(unit_,         rhs.unit_);
+  std::swap(needs_unlock_, rhs.needs_unlock_);
+
+  return *this;
+}
+
+
+
+
+
+namespace {
+  [[nodiscard]] GLuint generate_sampler() {
+    GLuint name{0};
+    glGenSamplers(1, &name);
+    return name;
+  }
+}
+
+
+
+gl::sampler::sampler(GLenum wrap, GLenum filter) :
+  sampler_{generate_sampler()}
+{
+  glSamplerParameteri(sampler_.get(), GL_TEXTURE_WRAP_S,     static_cast<GLint>(wrap));
+  glSamplerParameteri(sampler_.get(), GL_TEXTURE_WRAP_T,     static_cast<GLint>(wrap));
+  glSamplerParameteri(sampler_.get(), GL_TEXTURE_MIN_FILTER, static_cast<GLint>(filter));
+  glSamplerParameteri(sampler_.get(), GL_TEXTURE_MAG_FILTER, static_cast<GLint>(filter));
+}
+
+
+
+gl::sampler::sampler_lock gl::sampler::bind(GLuint unit) const {
+  glBindSampler(unit, sampler_.get());
+  return sampler_lock{unit};
+}
@@ -1,6 +1,10 @@
 #include "gl/texture.hpp"
 
+#include <algorithm>
+#include <atomic>
+#include <bit>
 #include <stdexcept>
+#include <utility>
 
 #include <cassert>
 
@@ -10,6 +14,7 @@ namespace {
     switch (format) {
       case gl::texture::format::rgb8:             return GL_RGB8;
       case gl::texture::format::rgba8:            return GL_RGBA8;
+      case gl::texture::format::rgba16_be:        return GL_RGBA16;
     }
     throw std::runtime_error{"unsupported texture format"};
   }
@@ -19,7 +24,8 @@ namespace {
   [[nodiscard]] GLenum format_to_format(gl::texture::format format) {
     switch (format) {
       case gl::texture::format::rgb8:             return GL_RGB;
-      case gl::texture::format::rgba8:            return GL_RGBA;
+      case gl::texture::format::rgba8:
+      case gl::texture::format::rgba16_be:        return GL_RGBA;
     }
     throw std::runtime_error{"unsupported texture format"};
   }
@@ -30,6 +36,7 @@ namespace {
     switch (format) {
       case gl::texture::format::rgb8:
       case gl::texture::format::rgba8:            return GL_UNSIGNED_BYTE;
+      case gl::texture::format::rgba16_be:        return GL_UNSIGNED_SHORT;
     }
     throw std::runtime_error{"unsupported texture format"};
   }
@@ -48,16 +55,54 @@ namespace {
 
 
 
+  [[nodiscard]] size_t bytes_per_pixel(gl::texture::format format) {
+    switch (format) {
+      case gl::texture::format::rgb8:             return 3;
+      case gl::texture::format::rgba8:            return 4;
+      case gl::texture::format::rgba16_be:        return 8;
+    }
+    throw std::runtime_error{"unsupported texture format"};
+  }
+
+
+
+  [[nodiscard]] GLint swap_bytes(gl::texture::format format) {
+    if (format == gl::texture::format::rgba16_be && std::endian::native == std::endian::little) {
+      return GL_TRUE;
+    }
+    return GL_FALSE;
+  }
+
+
+
   [[nodiscard]] GLint pixels_per_stride(size_t stride, gl::texture::format format) {
     switch (format) {
       case gl::texture::format::rgb8:             return stride / 3;
       case gl::texture::format::rgba8:            return stride / 4;
+      case gl::texture::format::rgba16_be:        return stride / 8;
+    }
+    throw std::runtime_error{"unsupported texture format"};
+  }
+
+
+
+
+
+  // drivers pad rgb8 to four bytes per texel
+  [[nodiscard]] size_t bytes_per_texel(gl::texture::format format) {
+    switch (format) {
+      case gl::texture::format::rgb8:
+      case gl::texture::format::rgba8:            return 4;
+      case gl::texture::format::rgba16_be:        return 8;
     }
     throw std::runtime_error{"unsupported texture format"};
   }
 
 
 
+  std::atomic<size_t> allocated_bytes{0};
+  std::atomic<size_t> peak_bytes     {0};
+
 
 
   [[nodiscard]] GLuint generate_texture() {
@@ -75,6 +120,46 @@ gl::texture::texture() :
 
 
 
+void gl::texture::deleter::operator()(GLuint t) const {
+  allocated_bytes -= bytes;
+  glDeleteTextures(1, &t);
+}
+
+
+
+void gl::texture::track_storage(texture_size size, format fmt, GLsizei levels) {
+  size_t bytes{0};
+
+  for (GLsizei level = 0; level < levels; ++level) {
+    bytes += static_cast<size_t>(std::max(1, size.width  >> level))
+           * static_cast<size_t>(std::max(1, size.height >> level))
+           * bytes_per_texel(fmt);
+  }
+
+  allocated_bytes -= std::exchange(texture_.deleter().bytes, bytes);
+  auto current = allocated_bytes += bytes;
+
+  auto peak = peak_bytes.load();
+  while (current > peak && !peak_bytes.compare_exchange_weak(peak, current)) {}
+}
+
+
+
+gl::texture::memory_usage gl::texture::allocated_memory() {
+  return {
+    .current = allocated_bytes.load(),
+    .peak    = peak_bytes.load()
+  };
+}
+
+
+
+void gl::texture::reset_peak_memory() {
+  peak_bytes = allocated_bytes.load();
+}
+
+
+
 gl::texture::texture(texture_size size, format fmt) :
   texture{size.width, size.height, fmt}
 {}
@@ -90,6 +175,7 @@ gl::texture::texture(GLsizei width, GLsizei height, format fmt) :
       width, height, 0,
       format_to_format(fmt),
       format_to_type(fmt), nullptr);
+  track_storage({width, height}, fmt);
 
   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
@@ -103,7 +189,8 @@ gl::texture::texture(
     GLsizei                    width,
     GLsizei                    height,
     std::span<const std::byte> data,
-    format                     fmt
+    format                     fmt,
+    GLsizei                    levels
 ) :
   texture{}
 {
@@ -114,12 +201,21 @@ gl::texture::texture(
 
   glPixelStorei(GL_UNPACK_ALIGNMENT,  unpack_alignment(stride));
   glPixelStorei(GL_UNPACK_ROW_LENGTH, pixels_per_stride(stride, fmt));
+  glPixelStorei(GL_UNPACK_SWAP_BYTES, swap_bytes(fmt));
 
   glTexImage2D(GL_TEXTURE_2D, 0, format_to_internal(fmt),
       width, height, 0,
       format_to_format(fmt),
       format_to_type(fmt), data.data());
 
+  glPixelStorei(GL_UNPACK_SWAP_BYTES, GL_FALSE);
+
+  if (levels > 1) {
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levels - 1);
+    glGenerateMipmap(GL_TEXTURE_2D);
+  }
+  track_storage({width, height}, fmt, std::max(levels, 1));
+
   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
 
@@ -130,9 +226,132 @@ gl::texture::texture(
 
 
 
+gl::texture gl::texture::immutable(texture_size size, format fmt, GLsizei levels) {
+  levels = std::max(levels, 1);
+
+  texture output;
+  output.bind();
+
+  glTexStorage2D(GL_TEXTURE_2D, levels, format_to_internal(fmt), size.width, size.height);
+  output.track_storage(size, fmt, levels);
+
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+
+  unbind();
+
+  return output;
+}
+
+
+
+void gl::texture::update(
+    GLint        first_row,
+    texture_size rows,
+    size_t       stride,
+    const void*  pixels,
+    format       fmt
+) const {
+  bind();
+
+  glPixelStorei(GL_UNPACK_ALIGNMENT,  unpack_alignment(stride));
+  glPixelStorei(GL_UNPACK_ROW_LENGTH, pixels_per_stride(stride, fmt));
+  glPixelStorei(GL_UNPACK_SWAP_BYTES, swap_bytes(fmt));
+
+  glTexSubImage2D(GL_TEXTURE_2D, 0, 0, first_row, rows.width, rows.height,
+      format_to_format(fmt), format_to_type(fmt), pixels);
+
+  glPixelStorei(GL_UNPACK_SWAP_BYTES, GL_FALSE);
+
+  unbind();
+}
+
+
+
+
+
+void gl::texture::generate_mipmaps() const {
+  bind();
+  glGenerateMipmap(GL_TEXTURE_2D);
+  unbind();
+}
+
+
+
+
+
+gl::texture_size gl::texture::size() const {
+  bind();
+  auto output = active_texture_size();
+  unbind();
+
+  return output;
+}
+
+
+
+std::vector<std::byte> gl::texture::download(format fmt) const {
+  bind();
+
+  auto size = active_texture_size();
+
+  std::vector<std::byte> output(static_cast<size_t>(size.width)
+                                * static_cast<size_t>(size.height)
+                                * bytes_per_pixel(fmt));
+
+  glPixelStorei(GL_PACK_ALIGNMENT,  1);
+  glPixelStorei(GL_PACK_ROW_LENGTH, 0);
+  glPixelStorei(GL_PACK_SWAP_BYTES, swap_bytes(fmt));
+
+  glGetTexImage(GL_TEXTURE_2D, 0, format_to_format(fmt), format_to_type(fmt),
+      output.data());
+
+  glPixelStorei(GL_PACK_SWAP_BYTES, GL_FALSE);
+
+  unbind();
+
+  return output;
+}
+
+
+
+
+
 gl::texture_size gl::active_texture_size() {
   texture_size out;
   glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_WIDTH,  &out.width);
   glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_HEIGHT, &out.height);
   return out;
 }
+
+
+
+GLsizei gl::active_texture_levels() {
+  GLint max_level{0};
+  glGetTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, &max_level);
+
+  GLsizei levels{1};
+  for (; levels <= max_level; ++levels) {
+    GLint width{0};
+    glGetTexLevelParameteriv(GL_TEXTURE_2D, levels, GL_TEXTURE_WIDTH, &width);
+    if (width == 0) {
+      break;
+    }
+  }
+
+  return levels;
+}
+
+
+
+GLsizei gl::mipmap_levels(texture_size size, float factor) {
+  GLsizei levels{1};
+
+  for (; factor >= 2.f && std::max(size.width, size.height) > 1; factor /= 2.f) {
+    size.width  = std::max(1, size.width  / 2);
+    size.height = std::max(1, size.height / 2);
+    ++levels;
+  }
+
+  return levels;
+}
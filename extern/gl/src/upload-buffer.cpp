@@ -0,0 +1,73 @@
+#include "gl/upload-buffer.hpp"
+
+#include <stdexcept>
+
+
+
+namespace {
+  constexpr GLbitfield mapping_flags{GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT
+                                     | GL_MAP_COHERENT_BIT};
+
+
+
+  [[nodiscard]] GLuint generate_buffer() {
+    GLuint buffer{0};
+    glGenBuffers(1, &buffer);
+    return buffer;
+  }
+}
+
+
+
+gl::upload_buffer::upload_buffer(size_t size) :
+  buffer_{generate_buffer()}
+{
+  glBindBuffer(GL_PIXEL_UNPACK_BUFFER, buffer_.get());
+
+  glBufferStorage(GL_PIXEL_UNPACK_BUFFER, static_cast<GLsizeiptr>(size), nullptr,
+      mapping_flags);
+
+  auto* mapping = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0,
+      static_cast<GLsizeiptr>(size), mapping_flags);
+
+  glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+  if (mapping == nullptr) {
+    throw std::runtime_error{"unable to map pixel unpack buffer"};
+  }
+
+  mapping_ = {static_cast<std::byte*>(mapping), size};
+}
+
+
+
+void gl::upload_buffer::upload(
+    const texture&  target,
+    GLint           first_row,
+    texture_size    rows,
+    size_t          stride,
+    texture::format fmt
+) const {
+  glBindBuffer(GL_PIXEL_UNPACK_BUFFER, buffer_.get());
+
+  target.update(first_row, rows, stride,
+      reinterpret_cast<const void*>(static_cast<size_t>(first_row) * stride), fmt); // NOLINT
+
+  glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+}
+
+
+
+void gl::upload_buffer::finish() {
+  fence_.emplace();
+}
+
+
+
+void gl::upload_buffer::wait() const {
+  if (!fence_) {
+    return;
+  }
+
+  while (!fence_->client_wait(std::chrono::milliseconds{100})) {}
+}
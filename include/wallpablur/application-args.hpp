@@ -4,8 +4,11 @@
 #include <filesystem>
 #include <optional>
 #include <span>
+#include <string>
 #include <string_view>
 
+#include <vec2.hpp>
+
 
 
 struct blur_args {
@@ -17,6 +20,18 @@ struct blur_args {
 
 
 
+struct render_args {
+  std::optional<std::filesystem::path> target;
+  std::optional<std::filesystem::path> layout;
+  std::optional<std::string>           output;
+
+  std::optional<vec2<uint32_t>>        size;
+  float                                scale{1.f};
+  bool                                 cache{false};
+};
+
+
+
 struct application_args {
   bool help    {false};
   bool version {false};
@@ -30,6 +45,8 @@ struct application_args {
   blur_args                                blur;
   std::optional<std::filesystem::path>     image;
 
+  render_args                              render;
+
 
 
   [[nodiscard]] static std::optional<application_args> parse(std::span<char*>);
@@ -4,6 +4,7 @@
 #include "wallpablur/config/output.hpp"
 
 #include <chrono>
+#include <cstdint>
 #include <string_view>
 #include <vector>
 
@@ -29,6 +30,18 @@ class config {
     [[nodiscard]] bool     disable_i3ipc() const { return disable_i3ipc_;            }
     [[nodiscard]] bool     as_overlay()    const { return as_overlay_;               }
     [[nodiscard]] float    opacity()       const { return opacity_;                  }
+    [[nodiscard]] bool     disk_cache()    const { return disk_cache_;               }
+    [[nodiscard]] bool     watch_images()  const { return watch_images_;             }
+
+    [[nodiscard]] enum filter_backend filter_backend() const { return filter_backend_; }
+
+    [[nodiscard]] uint32_t texture_memory_budget_mb() const {
+      return texture_memory_budget_mb_;
+    }
+
+    [[nodiscard]] uint32_t disk_cache_size_mb() const { return disk_cache_size_mb_; }
+
+    [[nodiscard]] uint32_t source_cache_size_mb() const { return source_cache_size_mb_; }
 
 
 
@@ -39,6 +52,14 @@ class config {
     void disable_i3ipc(bool  disable) { disable_i3ipc_ = disable || disable_i3ipc_; }
     void as_overlay   (bool  overlay) { as_overlay_    = overlay; }
     void opacity      (float opacity) { opacity_       = opacity; }
+    void disk_cache   (bool  enable)  { disk_cache_    = enable;  }
+    void watch_images (bool  enable)  { watch_images_  = enable;  }
+
+    void filter_backend(enum filter_backend backend) { filter_backend_ = backend; }
+
+    void texture_memory_budget_mb(uint32_t mb) { texture_memory_budget_mb_ = mb; }
+    void disk_cache_size_mb      (uint32_t mb) { disk_cache_size_mb_       = mb; }
+    void source_cache_size_mb    (uint32_t mb) { source_cache_size_mb_     = mb; }
 
 
 
@@ -49,6 +70,12 @@ class config {
     bool                      disable_i3ipc_{false};
     bool                      as_overlay_   {false};
     float                     opacity_      {1.f};
+    bool                      disk_cache_   {true};
+    bool                      watch_images_ {true};
+    enum filter_backend       filter_backend_{filter_backend::gl};
+    uint32_t                  texture_memory_budget_mb_{512};
+    uint32_t                  disk_cache_size_mb_{1024};
+    uint32_t                  source_cache_size_mb_{128};
 
 
 
@@ -29,15 +29,42 @@ struct box_blur_filter {
 
 
 
+struct gaussian_blur_filter {
+  vec2<uint32_t> size{96};
+  float          dithering {1.f};
+
+  bool operator==(const gaussian_blur_filter&) const = default;
+};
+
+
+
+struct kawase_blur_filter {
+  unsigned int radius   {96};
+  float        dithering{1.f};
+
+  bool operator==(const kawase_blur_filter&) const = default;
+};
+
+
+
 using filter = std::variant<
   invert_filter,
-  box_blur_filter
+  box_blur_filter,
+  gaussian_blur_filter,
+  kawase_blur_filter
 >;
 
 
 
 
 
+enum class filter_backend {
+  gl,
+  cpu
+};
+
+
+
 enum class scale_mode {
   fit,
   zoom,
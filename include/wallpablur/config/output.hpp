@@ -7,6 +7,8 @@
 #include "wallpablur/surface-workspace-expression.hpp"
 #include "wallpablur/workspace-expression.hpp"
 
+#include <cstdint>
+#include <future>
 #include <memory>
 #include <optional>
 #include <string>
@@ -23,6 +25,10 @@ struct brush {
   std::optional<filter_graph>  fgraph;
 
   std::shared_ptr<gl::texture> realization;
+  std::shared_future<std::shared_ptr<gl::texture>>
+                               pending_realization;
+  bool                         realization_released{false};
+  uint64_t                     source_version{0};
 
 
 
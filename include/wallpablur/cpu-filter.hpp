@@ -0,0 +1,47 @@
+#ifndef WALLPABLUR_CPU_FILTER_HPP_INCLUDED
+#define WALLPABLUR_CPU_FILTER_HPP_INCLUDED
+
+#include "wallpablur/config/output.hpp"
+#include "wallpablur/image.hpp"
+#include "wallpablur/wayland/geometry.hpp"
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include <gl/texture.hpp>
+
+
+
+namespace cpu {
+
+// rgba8 pixels with premultiplied alpha; row 0 is the bottom row, as in a gl::texture
+struct pixel_buffer {
+  GLsizei              width {0};
+  GLsizei              height{0};
+  std::vector<uint8_t> data;
+
+
+
+  [[nodiscard]] std::span<uint8_t> row(size_t y) {
+    return std::span{data}.subspan(y * width * 4, width * 4);
+  }
+
+  [[nodiscard]] std::span<const uint8_t> row(size_t y) const {
+    return std::span{data}.subspan(y * width * 4, width * 4);
+  }
+};
+
+
+
+[[nodiscard]] pixel_buffer create_base_image(const wayland::geometry&,
+    const config::brush&, const image&);
+
+[[nodiscard]] bool         supports(const config::filter&);
+[[nodiscard]] pixel_buffer apply_filter(pixel_buffer&&, const config::filter&);
+
+[[nodiscard]] gl::texture  to_texture(const pixel_buffer&);
+
+}
+
+#endif // WALLPABLUR_CPU_FILTER_HPP_INCLUDED
@@ -0,0 +1,38 @@
+#ifndef WALLPABLUR_DAMAGE_REGION_HPP_INCLUDED
+#define WALLPABLUR_DAMAGE_REGION_HPP_INCLUDED
+
+#include "wallpablur/pixel-region.hpp"
+
+#include <span>
+#include <vector>
+
+#include <vec2.hpp>
+
+
+
+// union of pixel rectangles, approximated by a few bounding boxes
+class damage_region {
+  public:
+    static constexpr size_t max_rects{4};
+
+
+
+    void add(pixel_rect);
+    void add(const damage_region&);
+
+    void clip(vec2<uint32_t>);
+
+
+
+    [[nodiscard]] bool                        empty() const { return rects_.empty(); }
+    [[nodiscard]] std::span<const pixel_rect> rects() const { return rects_;         }
+
+    [[nodiscard]] size_t area() const;
+
+
+
+  private:
+    std::vector<pixel_rect> rects_;
+};
+
+#endif // WALLPABLUR_DAMAGE_REGION_HPP_INCLUDED
@@ -0,0 +1,49 @@
+#ifndef WALLPABLUR_DISK_CACHE_HPP_INCLUDED
+#define WALLPABLUR_DISK_CACHE_HPP_INCLUDED
+
+#include "wallpablur/config/filter.hpp"
+#include "wallpablur/config/output.hpp"
+#include "wallpablur/wayland/geometry.hpp"
+
+#include <filesystem>
+#include <optional>
+#include <string>
+
+#include <gl/texture.hpp>
+
+
+
+[[nodiscard]] std::optional<std::filesystem::path> cache_directory();
+
+
+
+class disk_cache {
+  public:
+    // results of different backends differ slightly, so they are kept apart; the oldest
+    // entries are removed once the directory exceeds `max_bytes`
+    disk_cache(std::filesystem::path, config::filter_backend, size_t max_bytes);
+
+
+
+    [[nodiscard]] std::optional<gl::texture> load(const wayland::geometry&,
+        const config::brush&) const;
+    [[nodiscard]] bool contains(const wayland::geometry&, const config::brush&) const;
+
+    void store(const wayland::geometry&, const config::brush&, const gl::texture&) const;
+
+
+
+  private:
+    std::filesystem::path  directory_;
+    config::filter_backend backend_;
+    size_t                 max_bytes_;
+
+    [[nodiscard]] std::optional<std::string> key(const wayland::geometry&,
+        const config::brush&) const;
+
+    [[nodiscard]] std::filesystem::path file_path(std::string_view) const;
+
+    void prune(std::string_view, const std::filesystem::path&) const;
+};
+
+#endif // WALLPABLUR_DISK_CACHE_HPP_INCLUDED
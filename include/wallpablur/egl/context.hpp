@@ -1,9 +1,11 @@
 #ifndef WALLPABLUR_EGL_CONTEXT_HPP_INCLUDED
 #define WALLPABLUR_EGL_CONTEXT_HPP_INCLUDED
 
+#include "wallpablur/damage-region.hpp"
 #include "wallpablur/exception.hpp"
 
 #include <source_location>
+#include <span>
 #include <string>
 
 #include <epoxy/gl.h>
@@ -36,14 +38,24 @@ class context {
 
     explicit context(NativeDisplayType);
 
+    // renders into a pbuffer of the given size without any window system, prefers
+    // mesa's surfaceless platform where available
+    [[nodiscard]] static context headless(EGLint, EGLint);
+
 
 
     [[nodiscard]] context share(NativeWindowType) const;
+    [[nodiscard]] context share() const;
 
 
 
     void make_current() const;
     void swap_buffers() const;
+    // falls back to swapping the whole buffer if `damage` is empty or unsupported
+    void swap_buffers(std::span<const pixel_rect> damage) const;
+
+    // frames since the back buffer was last presented, 0 if its contents are undefined
+    [[nodiscard]] EGLint buffer_age() const;
 
 
 
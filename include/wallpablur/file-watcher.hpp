@@ -0,0 +1,43 @@
+#ifndef WALLPABLUR_FILE_WATCHER_HPP_INCLUDED
+#define WALLPABLUR_FILE_WATCHER_HPP_INCLUDED
+
+#include "wallpablur/flat-map.hpp"
+
+#include <filesystem>
+#include <vector>
+
+
+
+class file_watcher {
+  public:
+    file_watcher(const file_watcher&) = delete;
+    file_watcher(file_watcher&&)      = delete;
+    file_watcher& operator=(const file_watcher&) = delete;
+    file_watcher& operator=(file_watcher&&)      = delete;
+
+    ~file_watcher();
+
+    file_watcher();
+
+
+
+    void watch(const std::filesystem::path&);
+
+    // watched paths which have been rewritten or replaced since the last call,
+    // never blocks
+    [[nodiscard]] std::vector<std::filesystem::path> changes();
+
+
+
+  private:
+    struct watched_file {
+      int                   descriptor;
+      std::filesystem::path name;
+    };
+
+    int                                           fd_{-1};
+
+    flat_map<std::filesystem::path, watched_file> files_;
+};
+
+#endif // WALLPABLUR_FILE_WATCHER_HPP_INCLUDED
@@ -1,7 +1,10 @@
 #ifndef GL_UTILS_HPP_INCLUDED
 #define GL_UTILS_HPP_INCLUDED
 
+#include <array>
 #include <span>
+#include <string>
+#include <string_view>
 
 #include <gl/mesh.hpp>
 
@@ -9,13 +12,53 @@
 
 namespace gl {
 
+// attributes 1 to 3 of meshes created with an instance buffer
+struct rect_instance {
+  std::array<GLfloat, 4> rect{0.f, 0.f, 0.f, 0.f};
+  // part of `rect` which is actually drawn
+  std::array<GLfloat, 4> clip{0.f, 0.f, 0.f, 0.f};
+  GLfloat                radius   {0.f};
+  GLfloat                thickness{0.f};
+  // bit mask of the sides with a border, starting at the top in clockwise order
+  GLfloat                sides    {0.f};
+  GLfloat                unused   {0.f};
+};
+
+
+
+class instance_buffer {
+  public:
+    instance_buffer();
+
+    [[nodiscard]] GLuint get() const { return buffer_.get(); }
+
+    // the previous contents are orphaned, so that pending draws do not stall
+    void upload(std::span<const rect_instance>) const;
+
+
+
+  private:
+    struct deleter {
+      void operator()(GLuint b) { glDeleteBuffers(1, &b); }
+    };
+
+    object_name<deleter> buffer_;
+};
+
+
+
 [[nodiscard]] gl::mesh mesh_from_vertices_indices(std::span<const GLfloat>,
-    std::span<const GLushort>);
+    std::span<const GLushort>, const instance_buffer* = nullptr);
+
+
+
+[[nodiscard]] gl::mesh create_quad(const instance_buffer* = nullptr);
 
 
 
-[[nodiscard]] gl::mesh create_quad();
-[[nodiscard]] gl::mesh create_sector(size_t);
+// inserts `text` (defines or shared functions) right after the #version line of `source`
+[[nodiscard]] std::string insert_after_version(std::string_view source,
+    std::string_view text);
 
 }
 
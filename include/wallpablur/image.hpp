@@ -0,0 +1,105 @@
+#ifndef WALLPABLUR_IMAGE_HPP_INCLUDED
+#define WALLPABLUR_IMAGE_HPP_INCLUDED
+
+#include "wallpablur/config/filter.hpp"
+#include "wallpablur/wayland/geometry.hpp"
+
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <span>
+
+#include <gl/texture.hpp>
+#include <gl/upload-buffer.hpp>
+
+#include <vec2.hpp>
+
+
+
+struct image {
+  GLsizei                    width {0};
+  GLsizei                    height{0};
+  size_t                     stride{0};
+  gl::texture::format        format{gl::texture::format::rgba8};
+
+  std::span<const std::byte> pixels;
+  std::shared_ptr<const void> storage;
+
+  vec2<uint32_t>             original_size{0};
+
+
+
+  [[nodiscard]] std::span<const std::byte> row(size_t y) const {
+    return pixels.subspan(y * stride, stride);
+  }
+};
+
+
+
+// smallest size at which an image still covers `size` when distributed with `scale`
+struct decode_target {
+  vec2<uint32_t>     size {0};
+  config::scale_mode scale{config::scale_mode::centered};
+
+  bool operator==(const decode_target&) const = default;
+};
+
+[[nodiscard]] vec2<uint32_t> decode_size(vec2<uint32_t>, std::span<const decode_target>);
+
+// mipmap levels needed to minify an image of the given size to the smallest target
+[[nodiscard]] GLsizei mipmap_levels(vec2<uint32_t>, std::span<const decode_target>);
+
+
+
+// lets loaders decode straight into memory provided by the caller, which is told about
+// every range of rows as soon as it is final
+struct image_sink {
+  std::function<std::span<std::byte>(GLsizei, GLsizei, size_t, gl::texture::format)>
+                                        allocate;
+  std::function<void(GLsizei, GLsizei)> rows_ready;
+};
+
+
+
+// maps formats which can be used without decoding (farbfeld), empty for any other file
+[[nodiscard]] std::optional<image> map_image(const std::filesystem::path&);
+
+// uses the gdk-pixbuf or png loader, depending on the build
+[[nodiscard]] image decode_image(const std::filesystem::path&,
+    std::span<const decode_target>, const image_sink&);
+
+// `sink` is not used for mapped images
+[[nodiscard]] image       load_image(const std::filesystem::path&,
+                              std::span<const decode_target> = {}, const image_sink& = {});
+[[nodiscard]] gl::texture to_texture(const image&, GLsizei levels = 1);
+
+
+
+// writes an rgba8 image with straight alpha as farbfeld (*.ff) or png
+void save_image(const std::filesystem::path&, const image&);
+
+void write_farbfeld(const std::filesystem::path&, const image&);
+
+// uses gdk-pixbuf or libpng, depending on the build
+void encode_png(const std::filesystem::path&, const image&);
+
+
+
+struct uploaded_image {
+  gl::texture    texture;
+  vec2<uint32_t> size;
+  vec2<uint32_t> original_size;
+};
+
+// uploads rows while the rest of the image is still being decoded; `buffer` is reused
+// across calls if it is large enough
+[[nodiscard]] uploaded_image load_texture(const std::filesystem::path&,
+    std::span<const decode_target>, std::optional<gl::upload_buffer>& buffer);
+
+
+
+[[nodiscard]] vec2<float> distribution_scale(config::scale_mode,
+    const wayland::geometry&, vec2<float>);
+
+#endif // WALLPABLUR_IMAGE_HPP_INCLUDED
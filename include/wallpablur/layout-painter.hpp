@@ -2,10 +2,12 @@
 #define WALLPABLUR_LAYOUT_PAINTER_HPP_INCLUDED
 
 #include "wallpablur/config/output.hpp"
+#include "wallpablur/damage-region.hpp"
 #include "wallpablur/egl/context.hpp"
 #include "wallpablur/texture-provider.hpp"
 
 #include <memory>
+#include <optional>
 
 #include <gl/program.hpp>
 #include <gl/mesh.hpp>
@@ -22,6 +24,7 @@ class layout_painter {
     ~layout_painter();
 
     explicit layout_painter(config::output);
+    layout_painter(config::output, std::shared_ptr<texture_provider>);
 
 
 
@@ -31,8 +34,12 @@ class layout_painter {
 
 
     void update_geometry(const wayland::geometry&);
+    bool update_textures(const workspace&);
+    void wait_for_textures(const workspace&) const;
 
-    void render_wallpaper(const workspace&, float, uint64_t) const;
+    // only redraws what changed since the back buffer was last presented and returns
+    // that region, an empty optional means the whole buffer was redrawn
+    std::optional<damage_region> render_wallpaper(const workspace&, float, uint64_t) const;
     void render_clipping(const workspace&, float, uint64_t) const;
     static void render_clear();
 
@@ -48,17 +55,27 @@ class layout_painter {
     struct wallpaper_context;
     struct clipping_context;
     class  radius_cache;
+    class  damage_tracker;
 
     std::unique_ptr<wallpaper_context>    wallpaper_context_;
     std::unique_ptr<clipping_context>     clipping_context_;
 
     std::unique_ptr<radius_cache>         radius_cache_;
 
+    std::unique_ptr<damage_tracker>       wallpaper_damage_;
+    std::unique_ptr<damage_tracker>       cache_damage_;
+
     wayland::geometry                     geometry_;
+    uint64_t                              texture_version_{0};
 
 
-    void draw_wallpaper(const workspace&, uint64_t) const;
+    // records the frame once and draws it to every damaged rectangle
+    void draw_wallpaper(const workspace&, uint64_t, float,
+        const std::optional<damage_region>&) const;
     void update_cache(const workspace&, uint64_t) const;
+
+    [[nodiscard]] std::optional<damage_region> update_damage(damage_tracker&,
+        const workspace&, float, EGLint) const;
 };
 
 
@@ -0,0 +1,51 @@
+#ifndef WALLPABLUR_PIXEL_REGION_HPP_INCLUDED
+#define WALLPABLUR_PIXEL_REGION_HPP_INCLUDED
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+
+
+// pixel rectangle in buffer coordinates with the origin at the top left
+struct pixel_rect {
+  int32_t x     {0};
+  int32_t y     {0};
+  int32_t width {0};
+  int32_t height{0};
+
+  bool operator==(const pixel_rect&) const = default;
+
+  [[nodiscard]] bool empty() const { return width <= 0 || height <= 0; }
+};
+
+[[nodiscard]] pixel_rect intersection(const pixel_rect&, const pixel_rect&);
+
+
+
+// exact union of disjoint pixel rectangles
+class pixel_region {
+  public:
+    static constexpr size_t max_rects{32};
+
+
+
+    pixel_region() = default;
+    explicit pixel_region(pixel_rect);
+
+    // removes `cut`, unless the difference needs more than max_rects rectangles, in which
+    // case the region is left unchanged
+    void subtract(const pixel_rect& cut);
+
+
+
+    [[nodiscard]] bool                        empty() const { return rects_.empty(); }
+    [[nodiscard]] std::span<const pixel_rect> rects() const { return rects_;         }
+
+
+
+  private:
+    std::vector<pixel_rect> rects_;
+};
+
+#endif // WALLPABLUR_PIXEL_REGION_HPP_INCLUDED
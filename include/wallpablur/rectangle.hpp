@@ -1,7 +1,6 @@
 #ifndef WALLPABLUR_RECTANGLE_HPP_INCLUDED
 #define WALLPABLUR_RECTANGLE_HPP_INCLUDED
 
-#include <array>
 #include <limits>
 
 #include <vec2.hpp>
@@ -43,8 +42,6 @@ class rectangle {
 
     [[nodiscard]] unsigned int rot_cw90() const { return rot_cw90_; }
 
-    [[nodiscard]] std::array<float, 16> to_matrix(const vec2<float>&) const;
-
 
 
     void inset(float thickness) {
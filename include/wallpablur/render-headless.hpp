@@ -0,0 +1,12 @@
+#ifndef WALLPABLUR_RENDER_HEADLESS_HPP_INCLUDED
+#define WALLPABLUR_RENDER_HEADLESS_HPP_INCLUDED
+
+
+
+struct application_args;
+
+// renders a single frame of the wallpaper surface into `args.render.target` without
+// connecting to a compositor and prints how long each stage took
+[[nodiscard]] int render_headless(const application_args& args);
+
+#endif // WALLPABLUR_RENDER_HEADLESS_HPP_INCLUDED
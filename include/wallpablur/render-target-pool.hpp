@@ -0,0 +1,42 @@
+#ifndef WALLPABLUR_RENDER_TARGET_POOL_HPP_INCLUDED
+#define WALLPABLUR_RENDER_TARGET_POOL_HPP_INCLUDED
+
+#include <vector>
+
+#include <gl/framebuffer.hpp>
+#include <gl/texture.hpp>
+
+
+
+struct render_target {
+  render_target(gl::texture_size, gl::texture::format);
+  render_target(gl::texture&&, gl::texture_size, gl::texture::format);
+
+  gl::texture_size    size;
+  gl::texture::format format;
+
+  gl::texture         texture;
+  gl::framebuffer     framebuffer;
+};
+
+
+
+class render_target_pool {
+  public:
+    [[nodiscard]] render_target acquire(gl::texture_size,
+        gl::texture::format = gl::texture::format::rgba8);
+
+    void recycle(render_target&&);
+    void recycle(gl::texture&&, gl::texture::format = gl::texture::format::rgba8);
+
+    void clear() { targets_.clear(); }
+
+
+
+  private:
+    static constexpr size_t max_targets_per_size{2};
+
+    std::vector<render_target> targets_;
+};
+
+#endif // WALLPABLUR_RENDER_TARGET_POOL_HPP_INCLUDED
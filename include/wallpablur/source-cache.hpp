@@ -0,0 +1,69 @@
+#ifndef WALLPABLUR_SOURCE_CACHE_HPP_INCLUDED
+#define WALLPABLUR_SOURCE_CACHE_HPP_INCLUDED
+
+#include "wallpablur/flat-map.hpp"
+#include "wallpablur/image.hpp"
+
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <span>
+#include <vector>
+
+#include <gl/texture.hpp>
+#include <gl/upload-buffer.hpp>
+
+
+
+struct source_request {
+  std::filesystem::path path;
+  decode_target         target;
+};
+
+
+
+class source_cache {
+  public:
+    // sources which are not part of the current plan are kept for later requests as long
+    // as they fit into `budget` bytes
+    explicit source_cache(size_t budget);
+
+
+
+    [[nodiscard]] const image&       decoded(const std::filesystem::path&,
+                                         const decode_target&);
+    [[nodiscard]] const gl::texture& texture(const std::filesystem::path&,
+                                         const decode_target&);
+
+    void plan(std::span<const source_request>);
+
+
+
+  private:
+    struct entry {
+      std::filesystem::file_time_type mtime;
+      std::vector<decode_target>      targets;
+
+      vec2<uint32_t>                  original_size{0};
+      vec2<uint32_t>                  size         {0};
+
+      std::optional<image>            decoded;
+      std::optional<gl::texture>      texture;
+
+      size_t                          bytes    {0};
+      uint64_t                        last_used{0};
+    };
+
+    flat_map<std::filesystem::path, entry> entries_;
+    std::optional<gl::upload_buffer>       upload_buffer_;
+
+    size_t                                 budget_;
+    uint64_t                               tick_{0};
+
+    [[nodiscard]] entry& lookup(const std::filesystem::path&, const decode_target&);
+    [[nodiscard]] static image load(entry&, const std::filesystem::path&);
+
+    void evict_unplanned();
+};
+
+#endif // WALLPABLUR_SOURCE_CACHE_HPP_INCLUDED
@@ -4,16 +4,24 @@
 #include "wallpablur/egl/context.hpp"
 #include "wallpablur/config/output.hpp"
 #include "wallpablur/flat-map.hpp"
+#include "wallpablur/render-target-pool.hpp"
+#include "wallpablur/source-cache.hpp"
 #include "wallpablur/wayland/geometry.hpp"
 
 #include <memory>
+#include <utility>
 
 #include <gl/mesh.hpp>
 #include <gl/program.hpp>
+#include <gl/sampler.hpp>
 #include <gl/texture.hpp>
 
 
 
+struct color_transform;
+
+
+
 class texture_generator {
   public:
     texture_generator(const texture_generator&) = delete;
@@ -30,8 +38,27 @@ class texture_generator {
     [[nodiscard]] gl::texture generate(const wayland::geometry&,
         const config::brush&) const;
 
+    // continues the filter chain of a texture which has its first filters applied already
     [[nodiscard]] gl::texture generate_from_existing(const gl::texture&,
-        const wayland::geometry&, std::span<const config::filter>) const;
+        const wayland::geometry&, std::span<const config::filter> filters,
+        size_t applied) const;
+
+    void make_context_current() const { context_->make_current(); }
+    void release_render_targets() const { render_target_pool_.clear(); }
+
+    void plan_sources(std::span<const source_request> requests) const {
+      source_cache_.plan(requests);
+    }
+
+    // large box blurs use a running sum if compute shaders are available, disabling it
+    // allows comparing against the fragment shader path
+    void use_running_sum(bool enable) { use_running_sum_ = enable; }
+
+    [[nodiscard]] static source_request source_request_for(const wayland::geometry&,
+        const config::brush&);
+
+    [[nodiscard]] static gl::texture_size storage_size(const wayland::geometry&,
+        const config::brush&);
 
 
 
@@ -41,19 +68,49 @@ class texture_generator {
     gl::mesh                              quad_;
     gl::program                           draw_texture_;
 
+    // inputs may be shared textures which are displayed by other contexts meanwhile,
+    // filter passes sample them through these instead of changing their parameters
+    gl::sampler                           line_sampler_;
+    gl::sampler                           blur_sampler_;
+    gl::sampler                           resample_sampler_;
+
     enum class shader {
       box_blur,
-      invert,
+      box_blur_running_sum,
+      gaussian_blur,
+      color,
+      kawase_down,
+      kawase_up,
+      downsample,
+      rescale,
     };
-    mutable flat_map<shader, gl::program> filter_shader_cache_;
+    mutable flat_map<std::pair<shader, bool>, gl::program> filter_shader_cache_;
+    mutable render_target_pool                             render_target_pool_;
+    mutable source_cache                                   source_cache_;
+
+    bool                                                   use_running_sum_{true};
 
+    [[nodiscard]] const gl::program& filter_shader(shader, bool color_transform = false) const;
 
 
-    [[nodiscard]] gl::texture create_base_texture(
+
+    [[nodiscard]] gl::texture generate_on_cpu(
         const wayland::geometry&, const config::brush&) const;
 
-    [[nodiscard]] gl::texture apply_filter(
-        const gl::texture&, const config::filter&, const wayland::geometry&) const;
+    [[nodiscard]] render_target create_base_texture(
+        const wayland::geometry&, const config::brush&, const color_transform&) const;
+
+    [[nodiscard]] render_target apply_filter(const gl::texture&, const config::filter&,
+        const color_transform&, const wayland::geometry&) const;
+
+    [[nodiscard]] render_target apply_color_transform(const gl::texture&,
+        const color_transform&) const;
+
+    [[nodiscard]] render_target upsample(const gl::texture&,
+        const wayland::geometry&, const color_transform&) const;
+
+    [[nodiscard]] gl::texture finalize(render_target&&, const wayland::geometry&,
+        std::span<const config::filter>) const;
 };
 
 #endif // WALLPABLUR_TEXTURE_GENERATOR_HPP_INCLUDED
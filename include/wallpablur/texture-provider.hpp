@@ -1,33 +1,123 @@
 #ifndef WALLPABLUR_TEXTURE_PROVIDER_HPP_INCLUDED
 #define WALLPABLUR_TEXTURE_PROVIDER_HPP_INCLUDED
 
+#include "wallpablur/disk-cache.hpp"
+#include "wallpablur/file-watcher.hpp"
 #include "wallpablur/flat-map.hpp"
 #include "wallpablur/texture-generator.hpp"
 
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <future>
 #include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <thread>
+#include <unordered_map>
 
 
 
 class texture_provider {
   public:
+    using texture_future = std::shared_future<std::shared_ptr<gl::texture>>;
+
+    texture_provider(const texture_provider&) = delete;
+    texture_provider(texture_provider&&)      = delete;
+    texture_provider& operator=(const texture_provider&) = delete;
+    texture_provider& operator=(texture_provider&&)      = delete;
+
+    ~texture_provider();
+
     explicit texture_provider(std::shared_ptr<egl::context>);
 
 
 
-    [[nodiscard]] std::shared_ptr<gl::texture> get(const wayland::geometry&,
-        const config::brush&);
+    [[nodiscard]] texture_future get(const wayland::geometry&, const config::brush&);
+
+    void prepare(const wayland::geometry&, std::span<const config::brush* const>);
 
     void cleanup();
 
+    // drops cached textures of source images which changed on disk
+    void reload_changed_sources();
+    [[nodiscard]] uint64_t source_version(const config::brush&);
+
 
 
 
 
   private:
-    using key = std::pair<wayland::geometry, config::brush>;
+    struct key {
+      vec2<uint32_t> size;
+      config::brush  brush;
+
+      bool operator==(const key&) const = default;
+    };
+
+    struct key_hash {
+      [[nodiscard]] size_t operator()(const key&) const;
+    };
+
+    struct entry {
+      texture_future               pending;
+      std::shared_ptr<gl::texture> texture;
+
+      size_t                       bytes    {0};
+      uint64_t                     last_used{0};
+
+      // shared prefix of other filter chains, dropped once they are done with it
+      bool                         intermediate{false};
+
+      // whether the task stores its result in the disk cache, shared with the queued
+      // task so that an intermediate requested as a brush of its own is stored as well
+      std::shared_ptr<std::atomic<bool>> persistent;
+    };
+
+    struct task {
+      wayland::geometry                          geometry;
+      config::brush                              brush;
+      std::shared_ptr<std::atomic<bool>>         persistent;
+
+      std::optional<texture_future>              base;
+      size_t                                     base_filter_count{0};
+
+      std::promise<std::shared_ptr<gl::texture>> promise;
+    };
+
+    std::shared_ptr<egl::context> context_;
+    std::optional<disk_cache>     disk_cache_;
+    std::unique_ptr<file_watcher> file_watcher_;
+
+    flat_map<std::filesystem::path, uint64_t>
+                                  source_versions_;
+
+    std::unordered_map<key, entry, key_hash>
+                                  cache_;
+    size_t                        memory_budget_;
+    size_t                        memory_usage_{0};
+    uint64_t                      tick_{0};
+
+    std::mutex                    queue_mutex_;
+    std::condition_variable_any   queue_cv_;
+    std::deque<task>              queue_;
+
+    std::jthread                  worker_thread_;
+
+
+
+    [[nodiscard]] texture_future request(const wayland::geometry&, const config::brush&,
+        bool);
+    [[nodiscard]] std::optional<std::pair<texture_future, size_t>> longest_prefix(
+        const wayland::geometry&, const config::brush&) const;
+
+    void evict(size_t);
+
+    void worker_loop(const std::stop_token&);
 
-    texture_generator                         texture_generator_;
-    flat_map<key, std::weak_ptr<gl::texture>> cache_;
+    [[nodiscard]] std::shared_ptr<gl::texture> process(
+        const texture_generator&, const task&) const;
 };
 
 #endif // WALLPABLUR_TEXTURE_PROVIDER_HPP_INCLUDED
@@ -19,6 +19,7 @@
 
 #include <functional>
 #include <memory>
+#include <optional>
 
 
 
@@ -55,7 +56,8 @@ class surface {
       update_cb_ = std::move(fnc);
     }
 
-    void set_render_cb(std::move_only_function<void(void)> fnc) {
+    // returns the region which changed, empty optional if the whole surface did
+    void set_render_cb(std::move_only_function<std::optional<damage_region>(void)> fnc) {
       render_cb_ = std::move(fnc);
     }
 
@@ -89,7 +91,8 @@ class surface {
     bool                                    as_overlay_         {false};
 
     std::move_only_function<bool(void)>     update_cb_;
-    std::move_only_function<void(void)>     render_cb_;
+    std::move_only_function<std::optional<damage_region>(void)>
+                                            render_cb_;
     std::move_only_function<void(std::shared_ptr<egl::context>)>
                                             context_cb_;
     std::move_only_function<void(const geometry&)>
@@ -10,6 +10,8 @@
 #include <mutex>
 #include <string>
 #include <thread>
+#include <utility>
+#include <vector>
 
 namespace wm {
 
@@ -57,6 +59,12 @@ class i3ipc {
     void update_layouts();
 };
 
+
+
+// active workspace of every output in a get_tree reply
+[[nodiscard]] std::vector<std::pair<std::string, workspace>> parse_layouts(
+    std::string_view);
+
 }
 
 #endif // WALLPABLUR_WM_I3IPC_HPP_INCLUDED
@@ -51,6 +51,7 @@ class workspace {
 
     [[nodiscard]] std::string_view         name()     const { return name_;     }
     [[nodiscard]] std::string_view         output()   const { return output_;   }
+    [[nodiscard]] vec2<float>              size()     const { return size_;     }
 
     [[nodiscard]] bool test_flag(workspace_flag) const;
 
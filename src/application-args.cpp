@@ -39,6 +39,20 @@ If an image path is provided, all outputs will use this image as wallpaper and a
 version as background. Additional options in this case:
 
   -b, --blur <rad>[:<iter>]   perform <iter> blur steps with radius <rad> (default: 96:2)
+
+To render a single frame without a Wayland compositor, print timings and exit:
+
+  --render-to <path>          write the wallpaper to <path> (farbfeld if it ends in .ff,
+                              png otherwise)
+  --layout <path>             take the windows from a tree in JSON format
+                              (e.g. `swaymsg -t get_tree`)
+  --output <name>             output to render (default: first output in the layout)
+  --size <w>x<h>              size in pixels (default: size of the output in the layout
+                              or 1920x1080)
+  --scale <scale>             scale factor of the output (default: 1)
+  --cache                     use the texture and shader caches on disk, which are
+                              disabled by default so that timings do not depend on
+                              earlier runs
 )";
 
 
@@ -46,6 +60,13 @@ version as background. Additional options in this case:
   enum class flags : int {
     as_overlay = 1000,
     opacity    = 1001,
+
+    render_to  = 1002,
+    layout     = 1003,
+    output     = 1004,
+    size       = 1005,
+    scale      = 1006,
+    cache      = 1007,
   };
 
 
@@ -70,6 +91,13 @@ version as background. Additional options in this case:
     option{"as-overlay", no_argument,       nullptr, std::to_underlying(flags::as_overlay)},
     option{"opacity",    required_argument, nullptr, std::to_underlying(flags::opacity)},
 
+    option{"render-to",  required_argument, nullptr, std::to_underlying(flags::render_to)},
+    option{"layout",     required_argument, nullptr, std::to_underlying(flags::layout)},
+    option{"output",     required_argument, nullptr, std::to_underlying(flags::output)},
+    option{"size",       required_argument, nullptr, std::to_underlying(flags::size)},
+    option{"scale",      required_argument, nullptr, std::to_underlying(flags::scale)},
+    option{"cache",      no_argument,       nullptr, std::to_underlying(flags::cache)},
+
     option{nullptr,         0,                 nullptr,   0}
   };
   //NOLINTEND(modernize-use-designated-initializers)
@@ -93,6 +121,24 @@ version as background. Additional options in this case:
 
 
 
+  [[nodiscard]] vec2<uint32_t> size_from_string(std::string_view input) {
+    auto pos = input.find('x');
+    if (pos == std::string_view::npos) {
+      throw exception{logcerr::format("expected <width>x<height>, got \"{}\"", input)};
+    }
+
+    auto width  = std::stoi(std::string{input.substr(0, pos)});
+    auto height = std::stoi(std::string{input.substr(pos + 1)});
+
+    if (width <= 0 || height <= 0) {
+      throw exception{logcerr::format("invalid size \"{}\"", input)};
+    }
+
+    return {static_cast<uint32_t>(width), static_cast<uint32_t>(height)};
+  }
+
+
+
   [[nodiscard]] application_args parse_args(std::span<char*> arg) {
     application_args args;
     int c{0};
@@ -112,6 +158,20 @@ version as background. Additional options in this case:
 
         case 'b': args.blur = blur_args_from_string(optarg); break;
 
+        case std::to_underlying(flags::render_to): args.render.target = optarg; break;
+        case std::to_underlying(flags::layout):    args.render.layout = optarg; break;
+        case std::to_underlying(flags::output):    args.render.output = optarg; break;
+
+        case std::to_underlying(flags::size):
+          args.render.size = size_from_string(optarg);
+          break;
+
+        case std::to_underlying(flags::scale):
+          args.render.scale = std::stof(optarg);
+          break;
+
+        case std::to_underlying(flags::cache): args.render.cache = true; break;
+
         default: break;
       }
     }
@@ -248,5 +308,9 @@ std::optional<application_args> application_args::parse(std::span<char*> arg) {
 
   overwrite_global_config_from_args(arg);
 
+  if (args.render.target && !args.render.cache) {
+    config::global_config().disk_cache(false);
+  }
+
   return args;
 }
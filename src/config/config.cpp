@@ -48,6 +48,10 @@ ICONFIGP_DEFINE_ENUM_LUT(scale_mode,
     "stretch",      stretch,
     "centered",     centered)
 
+ICONFIGP_DEFINE_ENUM_LUT(filter_backend,
+    "gl",           gl,
+    "cpu",          cpu)
+
 ICONFIGP_DEFINE_ENUM_LUT(scale_filter,
     "linear",       linear,
     "nearest",      nearest)
@@ -139,13 +143,17 @@ ICONFIGP_DEFINE_ENUM_LUT(surface_effect_type,
 enum class filter_type {
   invert,
   blur,
-  box_blur
+  box_blur,
+  gaussian,
+  kawase
 };
 
 ICONFIGP_DEFINE_ENUM_LUT(filter_type,
     "invert",   invert,
     "box-blur", box_blur,
-    "blur",     blur)
+    "blur",     blur,
+    "gaussian", gaussian,
+    "kawase",   kawase)
 
 
 
@@ -353,6 +361,21 @@ namespace {
 
         return output;
       }
+      case filter_type::gaussian: {
+        gaussian_blur_filter output;
+        update(filter, output.size.x(),   "width",  "radius"sv);
+        update(filter, output.size.y(),   "height", "radius"sv);
+        update(filter, output.dithering,  "dithering");
+
+        return output;
+      }
+      case filter_type::kawase: {
+        kawase_blur_filter output;
+        update(filter, output.radius,    "radius");
+        update(filter, output.dithering, "dithering");
+
+        return output;
+      }
       case filter_type::invert:
         return invert_filter{};
     }
@@ -546,6 +569,13 @@ cfg::config(std::string_view input) {
     update(root, as_overlay_,    "as-overlay");
     update(root, opacity_,       "opacity");
 
+    update(root, disk_cache_,    "disk-cache");
+    update(root, watch_images_,  "watch-images");
+    update(root, filter_backend_, "filter-backend");
+    update(root, texture_memory_budget_mb_, "texture-memory-budget-mb");
+    update(root, disk_cache_size_mb_,       "disk-cache-size-mb");
+    update(root, source_cache_size_mb_,     "source-cache-size-mb");
+
 
 
     default_output_ = parse_output(root, {});
@@ -0,0 +1,471 @@
+#include "wallpablur/cpu-filter.hpp"
+
+#include "wallpablur/exception.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <thread>
+
+#include <logcerr/log.hpp>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+
+
+namespace {
+  template<typename Function>
+  void parallel_for(size_t count, const Function& function) {
+    static constexpr size_t min_chunk{16};
+
+    size_t threads = std::clamp<size_t>(count / min_chunk, 1,
+                       std::max(1u, std::thread::hardware_concurrency()));
+    size_t chunk   = (count + threads - 1) / threads;
+
+    std::vector<std::jthread> workers;
+    workers.reserve(threads - 1);
+
+    for (size_t begin = chunk; begin < count; begin += chunk) {
+      workers.emplace_back([&function, begin, end = std::min(begin + chunk, count)] {
+          function(begin, end); });
+    }
+
+    function(0, std::min(chunk, count));
+  }
+
+
+
+  [[nodiscard]] int mirror(int index, int size) {
+    if (index >= 0 && index < size) {
+      return index;
+    }
+
+    int period = 2 * size;
+    int i      = (index < 0 ? -index - 1 : index) % period;
+
+    return i < size ? i : period - 1 - i;
+  }
+
+
+
+  [[nodiscard]] uint8_t to_unorm(float value) {
+    return static_cast<uint8_t>(std::clamp(value, 0.f, 1.f) * 255.f + 0.5f);
+  }
+}
+
+
+
+
+
+namespace {
+  // index of -1 marks a sample from the (transparent) border
+  struct sample_position {
+    int   first;
+    int   second;
+    float weight;
+  };
+
+
+
+  [[nodiscard]] int wrap(int index, int size, config::wrap_mode mode) {
+    switch (mode) {
+      case config::wrap_mode::none:
+        return index < 0 || index >= size ? -1 : index;
+      case config::wrap_mode::stretch_edge:
+        return std::clamp(index, 0, size - 1);
+      case config::wrap_mode::tiled:
+        return ((index % size) + size) % size;
+      case config::wrap_mode::tiled_mirror:
+        return mirror(index, size);
+    }
+
+    return -1;
+  }
+
+
+
+  // emulates `rescale-texture.*.glsl` along one axis
+  [[nodiscard]] std::vector<sample_position> sample_positions(
+      int                  output_size,
+      int                  input_size,
+      float                scale,
+      config::wrap_mode    wrap_mode,
+      config::scale_filter filter
+  ) {
+    std::vector<sample_position> positions;
+    positions.reserve(output_size);
+
+    for (int o = 0; o < output_size; ++o) {
+      float position = (static_cast<float>(o) + 0.5f) / static_cast<float>(output_size)
+                         * 2.f - 1.f;
+      float texel    = (scale * position + 1.f) / 2.f * static_cast<float>(input_size);
+
+      if (filter == config::scale_filter::nearest) {
+        auto index = wrap(static_cast<int>(std::floor(texel)), input_size, wrap_mode);
+        positions.push_back({.first = index, .second = index, .weight = 0.f});
+        continue;
+      }
+
+      texel -= 0.5f;
+      auto index = std::floor(texel);
+
+      positions.push_back({
+        .first  = wrap(static_cast<int>(index),     input_size, wrap_mode),
+        .second = wrap(static_cast<int>(index) + 1, input_size, wrap_mode),
+        .weight = texel - index
+      });
+    }
+
+    return positions;
+  }
+
+
+
+  [[nodiscard]] std::array<float, 4> texel(const image& img, int x, int y) {
+    if (x < 0 || y < 0) {
+      return {};
+    }
+
+    if (img.format == gl::texture::format::rgb8) {
+      const auto* pixel = img.row(y).subspan(x * 3).data();
+      return {
+        static_cast<float>(pixel[0]) / 255.f,
+        static_cast<float>(pixel[1]) / 255.f,
+        static_cast<float>(pixel[2]) / 255.f,
+        1.f
+      };
+    }
+
+    if (img.format == gl::texture::format::rgba16_be) {
+      const auto* pixel = img.row(y).subspan(x * 8).data();
+      auto channel = [pixel](size_t c) {
+        auto value = static_cast<unsigned int>(pixel[2 * c]) << 8u
+                   | static_cast<unsigned int>(pixel[2 * c + 1]);
+        return static_cast<float>(value) / 65535.f;
+      };
+      return {channel(0), channel(1), channel(2), channel(3)};
+    }
+
+    const auto* pixel = img.row(y).subspan(x * 4).data();
+    return {
+      static_cast<float>(pixel[0]) / 255.f,
+      static_cast<float>(pixel[1]) / 255.f,
+      static_cast<float>(pixel[2]) / 255.f,
+      static_cast<float>(pixel[3]) / 255.f
+    };
+  }
+
+
+
+  [[nodiscard]] std::array<float, 4> mix(
+      const std::array<float, 4>& a,
+      const std::array<float, 4>& b,
+      float                       weight
+  ) {
+    std::array<float, 4> result{};
+    for (size_t c = 0; c < result.size(); ++c) {
+      result[c] = a[c] * (1.f - weight) + b[c] * weight;
+    }
+    return result;
+  }
+}
+
+
+
+cpu::pixel_buffer cpu::create_base_image(
+  const wayland::geometry& geometry,
+  const config::brush&     brush,
+  const image&             img
+) {
+  const auto& distribution = brush.fgraph->distribution;
+
+  auto size  = vec2{static_cast<float>(img.width), static_cast<float>(img.height)};
+  auto scale = distribution_scale(distribution.scale, geometry, size);
+
+  logcerr::verbose("rescaling image {:#} -> {:#} on the cpu",
+      size, geometry.physical_size());
+
+  pixel_buffer output{
+    .width  = static_cast<GLsizei>(geometry.physical_size().x()),
+    .height = static_cast<GLsizei>(geometry.physical_size().y()),
+    .data   = {}
+  };
+  output.data.resize(static_cast<size_t>(output.width) * output.height * 4);
+
+  auto columns = sample_positions(output.width, img.width, scale.x(),
+                   distribution.wrap_x, distribution.filter);
+  auto rows    = sample_positions(output.height, img.height, -scale.y(),
+                   distribution.wrap_y, distribution.filter);
+
+  std::array<float, 4> background{};
+  for (size_t c = 0; c < 3; ++c) {
+    background[c] = static_cast<float>(to_unorm(brush.solid[c] * brush.solid[3])) / 255.f;
+  }
+  background[3] = static_cast<float>(to_unorm(brush.solid[3])) / 255.f;
+
+  parallel_for(output.height, [&](size_t begin, size_t end) {
+    for (size_t y = begin; y < end; ++y) {
+      auto target = output.row(y);
+      auto row    = rows[y];
+
+      for (size_t x = 0; x < columns.size(); ++x) {
+        auto column = columns[x];
+
+        auto color = mix(
+            mix(texel(img, column.first, row.first),
+                texel(img, column.second, row.first),  column.weight),
+            mix(texel(img, column.first, row.second),
+                texel(img, column.second, row.second), column.weight),
+            row.weight);
+
+        for (size_t c = 0; c < color.size(); ++c) {
+          target[x * 4 + c] = to_unorm(color[c] + background[c] * (1.f - color[3]));
+        }
+      }
+    }
+  });
+
+  return output;
+}
+
+
+
+
+
+namespace {
+#ifdef __SSE2__
+  struct rgba_sum {
+    __m128i lanes;
+  };
+
+  [[nodiscard]] rgba_sum zero_sum() { return {_mm_setzero_si128()}; }
+
+  [[nodiscard]] rgba_sum load(const uint8_t* pixel) {
+    int32_t value{};
+    std::memcpy(&value, pixel, sizeof(value));
+
+    auto zero = _mm_setzero_si128();
+    return {_mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(value), zero), zero)};
+  }
+
+  [[nodiscard]] rgba_sum add(rgba_sum a, rgba_sum b) { return {_mm_add_epi32(a.lanes, b.lanes)}; }
+  [[nodiscard]] rgba_sum sub(rgba_sum a, rgba_sum b) { return {_mm_sub_epi32(a.lanes, b.lanes)}; }
+
+  void store(uint8_t* pixel, rgba_sum sum, float scale, const std::array<float, 4>& noise) {
+    auto value = _mm_add_ps(_mm_loadu_ps(noise.data()),
+                   _mm_mul_ps(_mm_cvtepi32_ps(sum.lanes), _mm_set1_ps(scale)));
+
+    value = _mm_min_ps(_mm_max_ps(value, _mm_setzero_ps()), _mm_set1_ps(1.f));
+
+    auto packed = _mm_cvttps_epi32(
+                    _mm_add_ps(_mm_mul_ps(value, _mm_set1_ps(255.f)), _mm_set1_ps(0.5f)));
+    packed = _mm_packs_epi32(packed, packed);
+    packed = _mm_packus_epi16(packed, packed);
+
+    auto result = _mm_cvtsi128_si32(packed);
+    std::memcpy(pixel, &result, sizeof(result));
+  }
+#else
+  using rgba_sum = std::array<uint32_t, 4>;
+
+  [[nodiscard]] rgba_sum zero_sum() { return {}; }
+
+  [[nodiscard]] rgba_sum load(const uint8_t* pixel) {
+    return {pixel[0], pixel[1], pixel[2], pixel[3]};
+  }
+
+  [[nodiscard]] rgba_sum add(rgba_sum a, const rgba_sum& b) {
+    for (size_t c = 0; c < a.size(); ++c) { a[c] += b[c]; }
+    return a;
+  }
+
+  [[nodiscard]] rgba_sum sub(rgba_sum a, const rgba_sum& b) {
+    for (size_t c = 0; c < a.size(); ++c) { a[c] -= b[c]; }
+    return a;
+  }
+
+  void store(uint8_t* pixel, const rgba_sum& sum, float scale,
+      const std::array<float, 4>& noise) {
+    for (size_t c = 0; c < sum.size(); ++c) {
+      pixel[c] = to_unorm(noise[c] + static_cast<float>(sum[c]) * scale);
+    }
+  }
+#endif
+
+
+
+  // same as `noise()` in `filter-line-blur.fs.glsl`
+  [[nodiscard]] std::array<float, 4> noise(float x, float y, float dithering) {
+    static constexpr std::array<float, 4> factors{420.420f, 47.47f, 69.69f, 42.42f};
+
+    if (dithering == 0.f) {
+      return {};
+    }
+
+    float seed = x * 2718.28f + y * 3141.592f;
+
+    std::array<float, 4> result{};
+    for (size_t c = 0; c < result.size(); ++c) {
+      auto value = seed * factors[c];
+      result[c] = (value - std::floor(value) - 0.5f) * dithering;
+    }
+    return result;
+  }
+
+
+
+  [[nodiscard]] float frag_coord(size_t index, GLsizei size) {
+    return (static_cast<float>(index) + 0.5f) / static_cast<float>(size);
+  }
+
+
+
+  void blur_rows(
+      const cpu::pixel_buffer& input,
+      cpu::pixel_buffer&       output,
+      int                      samples,
+      float                    dithering
+  ) {
+    auto scale  = 1.f / (255.f * static_cast<float>(2 * samples + 1));
+    auto length = input.width;
+
+    parallel_for(input.height, [&](size_t begin, size_t end) {
+      for (size_t y = begin; y < end; ++y) {
+        const auto* source = input.row(y).data();
+        auto*       target = output.row(y).data();
+
+        auto sum = zero_sum();
+        for (int i = -samples; i <= samples; ++i) {
+          sum = add(sum, load(source + 4 * mirror(i, length)));
+        }
+
+        auto fy = frag_coord(y, input.height);
+
+        for (int p = 0; p < length; ++p) {
+          store(target + 4 * p, sum, scale, noise(frag_coord(p, input.width), fy, dithering));
+
+          sum = add(sum, load(source + 4 * mirror(p + samples + 1, length)));
+          sum = sub(sum, load(source + 4 * mirror(p - samples,     length)));
+        }
+      }
+    });
+  }
+
+
+
+  void blur_columns(
+      const cpu::pixel_buffer& input,
+      cpu::pixel_buffer&       output,
+      int                      samples,
+      float                    dithering
+  ) {
+    auto scale  = 1.f / (255.f * static_cast<float>(2 * samples + 1));
+    auto length = input.height;
+
+    // every thread sums up whole rows of a strip of columns at once
+    parallel_for(input.width, [&](size_t begin, size_t end) {
+      std::vector<rgba_sum> sums(end - begin, zero_sum());
+
+      auto accumulate = [&](int row, const auto& op) {
+        const auto* source = input.row(row).data() + 4 * begin;
+        for (size_t k = 0; k < sums.size(); ++k) {
+          sums[k] = op(sums[k], load(source + 4 * k));
+        }
+      };
+
+      for (int i = -samples; i <= samples; ++i) {
+        accumulate(mirror(i, length), add);
+      }
+
+      for (int p = 0; p < length; ++p) {
+        auto* target = output.row(p).data() + 4 * begin;
+        auto  fy     = frag_coord(p, input.height);
+
+        for (size_t k = 0; k < sums.size(); ++k) {
+          store(target + 4 * k, sums[k], scale,
+              noise(frag_coord(begin + k, input.width), fy, dithering));
+        }
+
+        accumulate(mirror(p + samples + 1, length), add);
+        accumulate(mirror(p - samples,     length), sub);
+      }
+    });
+  }
+
+
+
+  [[nodiscard]] cpu::pixel_buffer box_blur(
+      cpu::pixel_buffer&&            input,
+      const config::box_blur_filter& filter
+  ) {
+    if (filter.iterations == 0) {
+      throw exception{"unable to apply box blur filter with 0 iterations"};
+    }
+
+    logcerr::verbose("applying box blur filter with scale {:#} and {} iterations on the cpu",
+        filter.size * 2 + vec2{1u}, filter.iterations);
+
+    cpu::pixel_buffer scratch{
+      .width  = input.width,
+      .height = input.height,
+      .data   = std::vector<uint8_t>(input.data.size())
+    };
+
+    auto dithering = filter.dithering / 255.f;
+
+    for (unsigned int i = 0; i < filter.iterations; ++i) {
+      blur_rows   (input,   scratch, static_cast<int>(filter.size.x()), dithering);
+      blur_columns(scratch, input,   static_cast<int>(filter.size.y()), dithering);
+    }
+
+    return std::move(input);
+  }
+
+
+
+  void invert(cpu::pixel_buffer& buffer) {
+    logcerr::verbose("applying invert filter on the cpu");
+
+    parallel_for(buffer.height, [&](size_t begin, size_t end) {
+      for (size_t y = begin; y < end; ++y) {
+        auto row = buffer.row(y);
+        for (size_t x = 0; x < row.size(); x += 4) {
+          for (size_t c = 0; c < 3; ++c) {
+            row[x + c] = static_cast<uint8_t>(255 - row[x + c]);
+          }
+        }
+      }
+    });
+  }
+}
+
+
+
+bool cpu::supports(const config::filter& filter) {
+  return std::holds_alternative<config::box_blur_filter>(filter)
+    || std::holds_alternative<config::invert_filter>(filter);
+}
+
+
+
+cpu::pixel_buffer cpu::apply_filter(pixel_buffer&& input, const config::filter& filter) {
+  if (const auto* bblur = std::get_if<config::box_blur_filter>(&filter)) {
+    return box_blur(std::move(input), *bblur);
+  }
+
+  if (std::holds_alternative<config::invert_filter>(filter)) {
+    invert(input);
+    return std::move(input);
+  }
+
+  throw exception{"trying to use unimplemented cpu filter"};
+}
+
+
+
+gl::texture cpu::to_texture(const pixel_buffer& buffer) {
+  return {buffer.width, buffer.height, std::as_bytes(std::span{buffer.data})};
+}
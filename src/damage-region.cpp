@@ -0,0 +1,87 @@
+#include "wallpablur/damage-region.hpp"
+
+#include <algorithm>
+
+
+
+namespace {
+  [[nodiscard]] bool touching(const pixel_rect& lhs, const pixel_rect& rhs) {
+    return lhs.x <= rhs.x + rhs.width  && rhs.x <= lhs.x + lhs.width
+        && lhs.y <= rhs.y + rhs.height && rhs.y <= lhs.y + lhs.height;
+  }
+
+
+
+  [[nodiscard]] pixel_rect bounds(const pixel_rect& lhs, const pixel_rect& rhs) {
+    auto x = std::min(lhs.x, rhs.x);
+    auto y = std::min(lhs.y, rhs.y);
+
+    return {
+      .x      = x,
+      .y      = y,
+      .width  = std::max(lhs.x + lhs.width,  rhs.x + rhs.width)  - x,
+      .height = std::max(lhs.y + lhs.height, rhs.y + rhs.height) - y
+    };
+  }
+}
+
+
+
+void damage_region::add(pixel_rect rect) {
+  if (rect.empty()) {
+    return;
+  }
+
+  auto touches = [&rect](const pixel_rect& r) { return touching(r, rect); };
+
+  // merging may make the result touch rectangles which it did not touch before
+  for (auto it = std::ranges::find_if(rects_, touches); it != rects_.end();
+       it = std::ranges::find_if(rects_, touches)) {
+    rect = bounds(rect, *it);
+    rects_.erase(it);
+  }
+
+  if (rects_.size() < max_rects) {
+    rects_.emplace_back(rect);
+    return;
+  }
+
+  for (const auto& r: rects_) {
+    rect = bounds(rect, r);
+  }
+
+  rects_ = {rect};
+}
+
+
+
+void damage_region::add(const damage_region& region) {
+  for (const auto& rect: region.rects_) {
+    add(rect);
+  }
+}
+
+
+
+void damage_region::clip(vec2<uint32_t> size) {
+  for (auto& rect: rects_) {
+    auto x0 = std::clamp<int32_t>(rect.x, 0, static_cast<int32_t>(size.x()));
+    auto y0 = std::clamp<int32_t>(rect.y, 0, static_cast<int32_t>(size.y()));
+    auto x1 = std::clamp<int32_t>(rect.x + rect.width,  0, static_cast<int32_t>(size.x()));
+    auto y1 = std::clamp<int32_t>(rect.y + rect.height, 0, static_cast<int32_t>(size.y()));
+
+    rect = {.x = x0, .y = y0, .width = x1 - x0, .height = y1 - y0};
+  }
+
+  std::erase_if(rects_, [](const auto& rect) { return rect.empty(); });
+}
+
+
+
+size_t damage_region::area() const {
+  size_t sum{0};
+  for (const auto& rect: rects_) {
+    sum += static_cast<size_t>(rect.width) * static_cast<size_t>(rect.height);
+  }
+  return sum;
+}
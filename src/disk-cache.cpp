@@ -0,0 +1,401 @@
+#include "wallpablur/disk-cache.hpp"
+#include "wallpablur/config/filter.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <cstdlib>
+#include <format>
+#include <fstream>
+#include <utility>
+#include <vector>
+
+#include <logcerr/log.hpp>
+
+
+
+std::optional<std::filesystem::path> cache_directory() {
+  if (const char* env = getenv("XDG_CACHE_HOME"); env != nullptr && *env != 0) {
+    return std::filesystem::path{env} / "wallpablur";
+  }
+
+  if (const char* env = getenv("HOME"); env != nullptr && *env != 0) {
+    return std::filesystem::path{env} / ".cache" / "wallpablur";
+  }
+
+  return {};
+}
+
+
+
+
+
+namespace {
+  constexpr std::array<char, 8> magic   {'W', 'P', 'B', 'C', 'A', 'C', 'H', 'E'};
+  constexpr uint32_t            version {1};
+
+
+
+  [[nodiscard]] std::string describe(const config::invert_filter& /*unused*/) {
+    return "invert";
+  }
+
+  [[nodiscard]] std::string describe(const config::box_blur_filter& filter) {
+    return std::format("box-blur:{}:{}:{}:{}", filter.size.x(), filter.size.y(),
+        filter.iterations, filter.dithering);
+  }
+
+  [[nodiscard]] std::string describe(const config::gaussian_blur_filter& filter) {
+    return std::format("gaussian:{}:{}:{}", filter.size.x(), filter.size.y(),
+        filter.dithering);
+  }
+
+  [[nodiscard]] std::string describe(const config::kawase_blur_filter& filter) {
+    return std::format("kawase:{}:{}", filter.radius, filter.dithering);
+  }
+
+
+
+  [[nodiscard]] std::string describe(const config::image_distribution& dist) {
+    return std::format("{}:{}:{}:{}",
+        std::to_underlying(dist.scale),  std::to_underlying(dist.wrap_x),
+        std::to_underlying(dist.wrap_y), std::to_underlying(dist.filter));
+  }
+
+
+
+  [[nodiscard]] uint64_t fnv1a(std::string_view input) {
+    uint64_t hash{0xcbf29ce484222325};
+
+    for (auto c: input) {
+      hash ^= static_cast<uint8_t>(c);
+      hash *= 0x100000001b3;
+    }
+
+    return hash;
+  }
+
+
+
+  template<typename T>
+  void write_value(std::ostream& out, T value) {
+    out.write(reinterpret_cast<const char*>(&value), sizeof(value)); // NOLINT
+  }
+
+  template<typename T>
+  [[nodiscard]] T read_value(std::istream& in) {
+    T value{};
+    in.read(reinterpret_cast<char*>(&value), sizeof(value)); // NOLINT
+    return value;
+  }
+
+
+
+  constexpr uint64_t max_key_length{1u << 16u};
+
+  struct header {
+    uint32_t    width {0};
+    uint32_t    height{0};
+    std::string key;
+  };
+
+  [[nodiscard]] std::optional<header> read_header(std::istream& input) {
+    auto file_magic   = read_value<std::array<char, 8>>(input);
+    auto file_version = read_value<uint32_t>(input);
+
+    header output;
+    output.width  = read_value<uint32_t>(input);
+    output.height = read_value<uint32_t>(input);
+
+    auto key_length = read_value<uint64_t>(input);
+
+    if (!input || file_magic != magic || file_version != version
+        || key_length > max_key_length) {
+      return {};
+    }
+
+    output.key.resize(key_length);
+    input.read(output.key.data(), static_cast<std::streamsize>(key_length));
+
+    if (!input) {
+      return {};
+    }
+
+    return output;
+  }
+
+
+
+  // the first lines of a key are the canonical path, modification time and size of the
+  // source image
+  [[nodiscard]] std::string_view path_of(std::string_view key) {
+    return key.substr(0, key.find('\n'));
+  }
+
+  [[nodiscard]] std::string_view source_of(std::string_view key) {
+    auto end = key.find('\n');
+    for (int line = 1; line < 3 && end != std::string_view::npos; ++line) {
+      end = key.find('\n', end + 1);
+    }
+    return key.substr(0, end);
+  }
+}
+
+
+
+
+
+disk_cache::disk_cache(
+  std::filesystem::path  directory,
+  config::filter_backend backend,
+  size_t                 max_bytes
+) :
+  directory_{std::move(directory)},
+  backend_  {backend},
+  max_bytes_{max_bytes}
+{}
+
+
+
+std::optional<std::string> disk_cache::key(
+  const wayland::geometry& geometry,
+  const config::brush&     brush
+) const {
+  if (!brush.fgraph) {
+    return {};
+  }
+
+  std::error_code ec;
+
+  auto path = std::filesystem::canonical(brush.fgraph->path, ec);
+  if (ec) {
+    return {};
+  }
+
+  auto mtime = std::filesystem::last_write_time(path, ec);
+  if (ec) {
+    return {};
+  }
+
+  auto file_size = std::filesystem::file_size(path, ec);
+  if (ec) {
+    return {};
+  }
+
+  auto output = std::format("{}\n{}\n{}\n{}x{}\n{}:{}:{}:{}\n{}\nbackend:{}",
+      path.string(), mtime.time_since_epoch().count(), file_size,
+      geometry.physical_size().x(), geometry.physical_size().y(),
+      brush.solid[0], brush.solid[1], brush.solid[2], brush.solid[3],
+      describe(brush.fgraph->distribution), std::to_underlying(backend_));
+
+  for (const auto& filter: brush.fgraph->filters) {
+    output += '\n';
+    output += std::visit([](const auto& f) { return describe(f); }, filter);
+  }
+
+  return output;
+}
+
+
+
+std::filesystem::path disk_cache::file_path(std::string_view key) const {
+  return directory_ / std::format("{:016x}.bin", fnv1a(key));
+}
+
+
+
+
+
+bool disk_cache::contains(
+  const wayland::geometry& geometry,
+  const config::brush&     brush
+) const {
+  auto k = key(geometry, brush);
+  if (!k) {
+    return false;
+  }
+
+  std::error_code ec;
+  return std::filesystem::is_regular_file(file_path(*k), ec);
+}
+
+
+
+std::optional<gl::texture> disk_cache::load(
+  const wayland::geometry& geometry,
+  const config::brush&     brush
+) const {
+  auto k = key(geometry, brush);
+  if (!k) {
+    return {};
+  }
+
+  auto path = file_path(*k);
+
+  std::ifstream input{path, std::ios::binary};
+  if (!input) {
+    return {};
+  }
+
+  auto file_header = read_header(input);
+
+  if (!file_header) {
+    logcerr::verbose("ignoring incompatible cache file {}", path.string());
+    return {};
+  }
+
+  auto [width, height, file_key] = std::move(*file_header);
+
+  // blurred textures are stored at a reduced resolution
+  if (file_key != *k || width == 0 || height == 0
+      || width > geometry.physical_size().x() || height > geometry.physical_size().y()) {
+    return {};
+  }
+
+  std::vector<std::byte> pixels(static_cast<size_t>(width) * height * 4);
+  input.read(reinterpret_cast<char*>(pixels.data()), // NOLINT
+      static_cast<std::streamsize>(pixels.size()));
+
+  if (!input) {
+    logcerr::warn("cache file {} is truncated", path.string());
+    return {};
+  }
+
+  logcerr::verbose("loaded texture from cache file {}", path.string());
+
+  // the modification time orders entries by their last use when pruning
+  std::error_code ec;
+  std::filesystem::last_write_time(path, std::filesystem::file_time_type::clock::now(), ec);
+
+  gl::texture texture{static_cast<GLsizei>(width), static_cast<GLsizei>(height), pixels};
+
+  texture.bind();
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+  return texture;
+}
+
+
+
+void disk_cache::store(
+  const wayland::geometry& geometry,
+  const config::brush&     brush,
+  const gl::texture&       texture
+) const {
+  auto k = key(geometry, brush);
+  if (!k) {
+    return;
+  }
+
+  auto size = texture.size();
+  if (size.width <= 0 || size.height <= 0) {
+    return;
+  }
+
+  auto path = file_path(*k);
+  auto tmp  = path;
+  tmp += ".tmp";
+
+  try {
+    std::filesystem::create_directories(directory_);
+
+    {
+      auto pixels = texture.download();
+
+      std::ofstream output{tmp, std::ios::binary | std::ios::trunc};
+
+      output.write(magic.data(), magic.size());
+      write_value<uint32_t>(output, version);
+      write_value<uint32_t>(output, size.width);
+      write_value<uint32_t>(output, size.height);
+      write_value<uint64_t>(output, k->size());
+      output.write(k->data(), static_cast<std::streamsize>(k->size()));
+      output.write(reinterpret_cast<const char*>(pixels.data()), // NOLINT
+          static_cast<std::streamsize>(pixels.size()));
+
+      if (!output.flush()) {
+        throw std::runtime_error{"unable to write data"};
+      }
+    }
+
+    std::filesystem::rename(tmp, path);
+
+    logcerr::verbose("stored texture in cache file {}", path.string());
+
+  } catch (std::exception& ex) {
+    logcerr::warn("unable to write cache file {}:\n{}", path.string(), ex.what());
+
+    std::error_code ec;
+    std::filesystem::remove(tmp, ec);
+    return;
+  }
+
+  prune(*k, path);
+}
+
+
+
+void disk_cache::prune(
+  std::string_view             stored_key,
+  const std::filesystem::path& stored
+) const {
+  struct cache_file {
+    std::filesystem::path           path;
+    std::filesystem::file_time_type last_used;
+    uintmax_t                       bytes;
+  };
+
+  try {
+    std::vector<cache_file> files;
+    uintmax_t total = std::filesystem::file_size(stored);
+
+    for (const auto& item: std::filesystem::directory_iterator{directory_}) {
+      if (!item.is_regular_file() || item.path().extension() != ".bin"
+          || item.path() == stored) {
+        continue;
+      }
+
+      std::optional<header> file_header;
+      {
+        std::ifstream input{item.path(), std::ios::binary};
+        file_header = read_header(input);
+      }
+
+      // unreadable, or generated from a previous version of the same source image
+      if (!file_header || (path_of(file_header->key) == path_of(stored_key)
+                           && source_of(file_header->key) != source_of(stored_key))) {
+        logcerr::verbose("removing stale cache file {}", item.path().string());
+        std::filesystem::remove(item.path());
+        continue;
+      }
+
+      files.push_back({item.path(), item.last_write_time(), item.file_size()});
+      total += files.back().bytes;
+    }
+
+    if (total <= max_bytes_) {
+      return;
+    }
+
+    std::ranges::sort(files, {}, &cache_file::last_used);
+
+    size_t count{0};
+    for (const auto& file: files) {
+      if (total <= max_bytes_) {
+        break;
+      }
+
+      std::filesystem::remove(file.path);
+      total -= file.bytes;
+      ++count;
+    }
+
+    logcerr::verbose("removed {} cache file(s) to stay within {} MiB", count,
+        max_bytes_ >> 20u);
+
+  } catch (std::exception& ex) {
+    logcerr::warn("unable to prune disk cache in {}:\n{}", directory_.string(), ex.what());
+  }
+}
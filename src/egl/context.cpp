@@ -1,9 +1,13 @@
 #include <wayland-egl.h>
 #include "wallpablur/egl/context.hpp"
 
+#include <EGL/eglext.h>
+
 #include <array>
+#include <string>
 #include <string_view>
 #include <utility>
+#include <vector>
 
 #include <logcerr/log.hpp>
 
@@ -127,6 +131,44 @@ void egl::context::enable_debugging() const {
 
 
 
+namespace {
+  [[nodiscard]] bool has_extension(EGLDisplay display, std::string_view name) {
+    const char* extensions = eglQueryString(display, EGL_EXTENSIONS);
+    if (extensions == nullptr) {
+      return false;
+    }
+
+    std::string_view list{extensions};
+    for (size_t pos = list.find(name); pos != std::string_view::npos;
+        pos = list.find(name, pos + 1)) {
+      auto end = pos + name.size();
+      if ((pos == 0 || list[pos - 1] == ' ') && (end == list.size() || list[end] == ' ')) {
+        return true;
+      }
+    }
+
+    return false;
+  }
+
+
+
+  [[nodiscard]] PFNEGLSWAPBUFFERSWITHDAMAGEKHRPROC swap_with_damage_function(
+      EGLDisplay display
+  ) {
+    for (const auto* name: {"KHR", "EXT"}) {
+      auto ext = std::string{"EGL_"} + name + "_swap_buffers_with_damage";
+      if (has_extension(display, ext)) {
+        return reinterpret_cast<PFNEGLSWAPBUFFERSWITHDAMAGEKHRPROC>( // NOLINT
+            eglGetProcAddress((std::string{"eglSwapBuffersWithDamage"} + name).c_str()));
+      }
+    }
+
+    return nullptr;
+  }
+}
+
+
+
 class egl::context::display_wrapper {
   public:
     display_wrapper(const display_wrapper&) = delete;
@@ -135,8 +177,8 @@ class egl::context::display_wrapper {
     display_wrapper& operator=(display_wrapper&&)      = delete;
 
 
-    display_wrapper(NativeDisplayType display)
-        : display_{eglGetDisplay(display)}
+    explicit display_wrapper(EGLDisplay display)
+        : display_{display}
     {
       if (display_ == EGL_NO_DISPLAY) {
         throw egl::error{"unable to obtain egl display"};
@@ -153,6 +195,12 @@ class egl::context::display_wrapper {
       eglBindAPI(EGL_OPENGL_API);
 
       eglSwapInterval(display_, 0);
+
+      buffer_age_       = has_extension(display_, "EGL_EXT_buffer_age");
+      swap_with_damage_ = swap_with_damage_function(display_);
+
+      logcerr::verbose("egl buffer age: {}, swap with damage: {}", buffer_age_,
+          swap_with_damage_ != nullptr);
     }
 
     ~display_wrapper() {
@@ -163,8 +211,16 @@ class egl::context::display_wrapper {
 
     EGLDisplay operator*() { return display_; }
 
+    [[nodiscard]] bool buffer_age() const { return buffer_age_; }
+
+    [[nodiscard]] PFNEGLSWAPBUFFERSWITHDAMAGEKHRPROC swap_with_damage() const {
+      return swap_with_damage_;
+    }
+
   private:
-    EGLDisplay display_;
+    EGLDisplay                         display_;
+    bool                               buffer_age_      {false};
+    PFNEGLSWAPBUFFERSWITHDAMAGEKHRPROC swap_with_damage_{nullptr};
 };
 
 
@@ -187,17 +243,62 @@ void egl::context::swap_buffers() const {
 
 
 
+void egl::context::swap_buffers(std::span<const pixel_rect> damage) const {
+  auto* swap_with_damage = display_->swap_with_damage();
+
+  if (damage.empty() || swap_with_damage == nullptr) {
+    swap_buffers();
+    return;
+  }
+
+  EGLint height{0};
+  if (eglQuerySurface(**display_, surface_, EGL_HEIGHT, &height) == EGL_FALSE) {
+    throw error{"unable to query surface height"};
+  }
+
+  // egl expects the origin at the bottom left
+  std::vector<EGLint> rects;
+  rects.reserve(damage.size() * 4);
+
+  for (const auto& rect: damage) {
+    rects.insert(rects.end(), {rect.x, height - rect.y - rect.height,
+                               rect.width, rect.height});
+  }
+
+  if (swap_with_damage(**display_, surface_, rects.data(),
+        static_cast<EGLint>(damage.size())) == EGL_FALSE) {
+    throw error{"unable to swap buffers"};
+  }
+}
+
+
+
+EGLint egl::context::buffer_age() const {
+  if (!display_->buffer_age()) {
+    return 0;
+  }
+
+  EGLint age{0};
+  if (eglQuerySurface(**display_, surface_, EGL_BUFFER_AGE_EXT, &age) == EGL_FALSE) {
+    return 0;
+  }
+
+  return age;
+}
+
+
+
 
 
 namespace {
-  [[nodiscard]] EGLConfig create_egl_config(EGLDisplay display) {
+  [[nodiscard]] EGLConfig create_egl_config(EGLDisplay display, EGLint surface_type) {
     EGLint count{0};
     if (eglGetConfigs(display, nullptr, 0, &count) != EGL_TRUE || count == 0) {
       throw egl::error{"unable to find egl configuration"};
     }
 
     const std::array<EGLint, 18> attrib = {
-      EGL_SURFACE_TYPE,    EGL_WINDOW_BIT,
+      EGL_SURFACE_TYPE,    surface_type,
       EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
       EGL_RED_SIZE,        8,
       EGL_GREEN_SIZE,      8,
@@ -233,6 +334,29 @@ namespace {
 
 
 
+  [[nodiscard]] EGLSurface create_egl_pbuffer(
+      EGLDisplay display,
+      EGLConfig  config,
+      EGLint     width,
+      EGLint     height
+  ) {
+    const std::array<EGLint, 6> attrib = {
+      EGL_WIDTH,  width,
+      EGL_HEIGHT, height,
+      EGL_NONE,   EGL_NONE,
+    };
+
+    EGLSurface surface = eglCreatePbufferSurface(display, config, attrib.data());
+
+    if (surface == EGL_NO_SURFACE) {
+      throw egl::error{"unable to create egl pbuffer"};
+    }
+
+    return surface;
+  }
+
+
+
   [[nodiscard]] EGLContext create_egl_context(
       EGLDisplay display,
       EGLConfig  config,
@@ -244,6 +368,9 @@ namespace {
       EGL_NONE,                  EGL_NONE,
     };
 
+    // the bound api is per thread, shared contexts may be created on worker threads
+    eglBindAPI(EGL_OPENGL_API);
+
     EGLContext context = eglCreateContext(display, config, shared, cx.data());
     if (context == EGL_NO_CONTEXT) {
       throw egl::error{"unable to create egl context"};
@@ -256,8 +383,8 @@ namespace {
 
 
 egl::context::context(NativeDisplayType display) :
-  display_{std::make_shared<display_wrapper>(display)},
-  config_ {create_egl_config(**display_)},
+  display_{std::make_shared<display_wrapper>(eglGetDisplay(display))},
+  config_ {create_egl_config(**display_, EGL_WINDOW_BIT)},
   surface_{EGL_NO_SURFACE},
   context_{create_egl_context(**display_, config_, EGL_NO_CONTEXT)}
 {
@@ -266,6 +393,32 @@ egl::context::context(NativeDisplayType display) :
 
 
 
+namespace {
+  [[nodiscard]] EGLDisplay headless_display() {
+    if (has_extension(EGL_NO_DISPLAY, "EGL_MESA_platform_surfaceless")) {
+      logcerr::verbose("using surfaceless egl platform");
+      return eglGetPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY,
+          nullptr);
+    }
+
+    return eglGetDisplay(EGL_DEFAULT_DISPLAY);
+  }
+}
+
+
+
+egl::context egl::context::headless(EGLint width, EGLint height) {
+  auto display = std::make_shared<display_wrapper>(headless_display());
+  auto config  = create_egl_config(**display, EGL_PBUFFER_BIT);
+
+  auto* surface = create_egl_pbuffer(**display, config, width, height);
+  auto* context = create_egl_context(**display, config, EGL_NO_CONTEXT);
+
+  return egl::context{std::move(display), config, surface, context};
+}
+
+
+
 egl::context::context(
     std::shared_ptr<display_wrapper> display,
     EGLConfig                        config,
@@ -313,6 +466,17 @@ egl::context egl::context::share(NativeWindowType window) const {
 
 
 
+egl::context egl::context::share() const {
+  return context {
+    display_,
+    config_,
+    EGL_NO_SURFACE,
+    create_egl_context(**display_, config_, context_)
+  };
+}
+
+
+
 egl::context::~context() {
   if (!display_) {
     return;
@@ -0,0 +1,112 @@
+#include "wallpablur/file-watcher.hpp"
+#include "wallpablur/exception.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <string_view>
+
+#include <logcerr/log.hpp>
+
+#include <sys/inotify.h>
+#include <unistd.h>
+
+
+
+file_watcher::file_watcher() {
+  check_errno("unable to initialize inotify", [&] {
+    fd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    return fd_ >= 0;
+  });
+}
+
+
+
+file_watcher::~file_watcher() {
+  if (fd_ >= 0) {
+    check_errno_nothrow("unable to close inotify", [&] {
+      return close(fd_) == 0;
+    });
+  }
+}
+
+
+
+
+
+void file_watcher::watch(const std::filesystem::path& path) {
+  if (files_.find_index(path)) {
+    return;
+  }
+
+  // watch the directory instead of the file itself, so that files which are replaced
+  // by renaming a new one over them are still being followed
+  auto absolute  = std::filesystem::absolute(path).lexically_normal();
+  auto directory = absolute.parent_path();
+
+  int descriptor = inotify_add_watch(fd_, directory.c_str(),
+      IN_CLOSE_WRITE | IN_MOVED_TO | IN_ONLYDIR);
+
+  if (descriptor < 0) {
+    logcerr::warn("unable to watch {} for changes: {}", path.string(),
+        std::strerror(errno));
+    return;
+  }
+
+  logcerr::verbose("watching {} for changes", path.string());
+
+  files_.emplace(path, watched_file{
+    .descriptor = descriptor,
+    .name       = absolute.filename()
+  });
+}
+
+
+
+
+
+std::vector<std::filesystem::path> file_watcher::changes() {
+  std::vector<std::filesystem::path> output;
+
+  auto add = [&output](const std::filesystem::path& path) {
+    if (std::ranges::find(output, path) == output.end()) {
+      output.emplace_back(path);
+    }
+  };
+
+  alignas(inotify_event) std::array<char, 4096> buffer{};
+
+  while (true) {
+    auto length = read(fd_, buffer.data(), buffer.size());
+    if (length <= 0) {
+      break;
+    }
+
+    for (ssize_t offset = 0; offset < length;) {
+      inotify_event event{};
+      std::memcpy(&event, buffer.data() + offset, sizeof(event));
+
+      std::string_view name;
+      if (event.len > 0) {
+        name = buffer.data() + offset + sizeof(event);
+      }
+      offset += static_cast<ssize_t>(sizeof(event) + event.len);
+
+      if ((event.mask & IN_Q_OVERFLOW) != 0) {
+        logcerr::verbose("inotify queue overflowed, assuming all files changed");
+        std::ranges::for_each(files_.keys(), add);
+        continue;
+      }
+
+      for (size_t i = 0; i < files_.size(); ++i) {
+        const auto& file = files_.values()[i];
+
+        if (file.descriptor == event.wd && file.name == name) {
+          add(files_.key(i));
+        }
+      }
+    }
+  }
+
+  return output;
+}
@@ -22,6 +22,6 @@ namespace {
 
 
 
-gl::mesh gl::create_quad() {
-  return mesh_from_vertices_indices(vertices, indices);
+gl::mesh gl::create_quad(const instance_buffer* instances) {
+  return mesh_from_vertices_indices(vertices, indices, instances);
 }
@@ -1,5 +1,7 @@
 #include "wallpablur/gl/utils.hpp"
 
+#include <cstddef>
+
 
 
 namespace {
@@ -30,6 +32,27 @@ namespace {
 
 
 
+  void bind_instance_buffer(const gl::instance_buffer& instances) {
+    glBindBuffer(GL_ARRAY_BUFFER, instances.get());
+
+    glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(gl::rect_instance),
+        reinterpret_cast<const void*>(offsetof(gl::rect_instance, rect))); // NOLINT
+    glVertexAttribDivisor(1, 1);
+    glEnableVertexAttribArray(1);
+
+    glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, sizeof(gl::rect_instance),
+        reinterpret_cast<const void*>(offsetof(gl::rect_instance, clip))); // NOLINT
+    glVertexAttribDivisor(2, 1);
+    glEnableVertexAttribArray(2);
+
+    glVertexAttribPointer(3, 4, GL_FLOAT, GL_FALSE, sizeof(gl::rect_instance),
+        reinterpret_cast<const void*>(offsetof(gl::rect_instance, radius))); // NOLINT
+    glVertexAttribDivisor(3, 1);
+    glEnableVertexAttribArray(3);
+  }
+
+
+
   [[nodiscard]] GLuint generate_index_buffer(std::span<const GLushort> indices) {
     GLuint ibo{0};
 
@@ -44,13 +67,48 @@ namespace {
 
 
 
+gl::instance_buffer::instance_buffer() {
+  GLuint buffer{0};
+  glGenBuffers(1, &buffer);
+  buffer_ = object_name<deleter>{buffer};
+}
+
+
+
+void gl::instance_buffer::upload(std::span<const rect_instance> instances) const {
+  glBindBuffer(GL_ARRAY_BUFFER, buffer_.get());
+  glBufferData(GL_ARRAY_BUFFER, instances.size_bytes(), instances.data(), GL_STREAM_DRAW);
+}
+
+
+
+
+
 gl::mesh gl::mesh_from_vertices_indices(
     std::span<const GLfloat>  vertices,
-    std::span<const GLushort> indices
+    std::span<const GLushort> indices,
+    const instance_buffer*    instances
 ) {
-  return gl::mesh{
-    generate_vertex_array(),
-    generate_vertex_buffer(vertices),
-    generate_index_buffer(indices)
-  };
+  auto vao = generate_vertex_array();
+  auto vbo = generate_vertex_buffer(vertices);
+
+  if (instances != nullptr) {
+    bind_instance_buffer(*instances);
+  }
+
+  return gl::mesh{vao, vbo, generate_index_buffer(indices)};
+}
+
+
+
+
+
+std::string gl::insert_after_version(std::string_view source, std::string_view text) {
+  auto version_end = source.find('\n') + 1;
+
+  std::string output{source.substr(0, version_end)};
+  output += text;
+  output += source.substr(version_end);
+
+  return output;
 }
@@ -0,0 +1,255 @@
+#include "wallpablur/image.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+#include <logcerr/log.hpp>
+
+
+
+vec2<uint32_t> decode_size(
+  vec2<uint32_t>                 image_size,
+  std::span<const decode_target> targets
+) {
+  if (targets.empty() || image_size.x() == 0 || image_size.y() == 0) {
+    return image_size;
+  }
+
+  float factor{0.f};
+
+  for (const auto& target: targets) {
+    auto s = div(vec_cast<float>(target.size), vec_cast<float>(image_size));
+
+    switch (target.scale) {
+      case config::scale_mode::fit:
+        factor = std::max(factor, std::min(s.x(), s.y()));
+        break;
+
+      case config::scale_mode::zoom:
+      case config::scale_mode::stretch:
+        factor = std::max(factor, std::max(s.x(), s.y()));
+        break;
+
+      case config::scale_mode::centered:
+        factor = 1.f;
+        break;
+    }
+  }
+
+  if (factor >= 1.f || factor <= 0.f) {
+    return image_size;
+  }
+
+  return {
+    std::max<uint32_t>(1, std::ceil(static_cast<float>(image_size.x()) * factor)),
+    std::max<uint32_t>(1, std::ceil(static_cast<float>(image_size.y()) * factor))
+  };
+}
+
+
+
+GLsizei mipmap_levels(vec2<uint32_t> image_size, std::span<const decode_target> targets) {
+  GLsizei levels{1};
+
+  for (const auto& target: targets) {
+    if (target.size.x() == 0 || target.size.y() == 0) {
+      continue;
+    }
+
+    auto s = div(vec_cast<float>(image_size), vec_cast<float>(target.size));
+
+    float factor{1.f};
+
+    switch (target.scale) {
+      case config::scale_mode::zoom:
+        factor = std::min(s.x(), s.y());
+        break;
+
+      // the level is chosen by the axis which is reduced the most
+      case config::scale_mode::fit:
+      case config::scale_mode::stretch:
+        factor = std::max(s.x(), s.y());
+        break;
+
+      case config::scale_mode::centered:
+        break;
+    }
+
+    levels = std::max(levels, gl::mipmap_levels({
+      .width  = static_cast<GLsizei>(image_size.x()),
+      .height = static_cast<GLsizei>(image_size.y())
+    }, factor));
+  }
+
+  return levels;
+}
+
+
+
+
+
+image load_image(
+  const std::filesystem::path&   path,
+  std::span<const decode_target> targets,
+  const image_sink&              sink
+) {
+  if (auto mapped = map_image(path)) {
+    return std::move(*mapped);
+  }
+
+  return decode_image(path, targets, sink);
+}
+
+
+
+gl::texture to_texture(const image& img, GLsizei levels) {
+  return {img.width, img.height, img.pixels, img.format, levels};
+}
+
+
+
+void save_image(const std::filesystem::path& path, const image& img) {
+  if (path.extension() == ".ff") {
+    write_farbfeld(path, img);
+  } else {
+    encode_png(path, img);
+  }
+}
+
+
+
+
+
+namespace {
+  // rows are uploaded in bands of about this many bytes
+  constexpr size_t upload_granularity{size_t{1} << 20u};
+
+
+
+  [[nodiscard]] vec2<uint32_t> img_size(const image& img) {
+    return {static_cast<uint32_t>(img.width), static_cast<uint32_t>(img.height)};
+  }
+
+
+
+  [[nodiscard]] bool streaming_upload_supported() {
+    return epoxy_gl_version() >= 44 || (epoxy_has_gl_extension("GL_ARB_buffer_storage")
+        && epoxy_has_gl_extension("GL_ARB_texture_storage"));
+  }
+}
+
+
+
+uploaded_image load_texture(
+  const std::filesystem::path&      path,
+  std::span<const decode_target>    targets,
+  std::optional<gl::upload_buffer>& buffer
+) {
+  if (!streaming_upload_supported()) {
+    auto img = load_image(path, targets);
+    return {
+      .texture       = to_texture(img, mipmap_levels(img_size(img), targets)),
+      .size          = img_size(img),
+      .original_size = img.original_size
+    };
+  }
+
+  std::optional<gl::texture> texture;
+  GLsizei                    width   {0};
+  GLsizei                    height  {0};
+  size_t                     stride  {0};
+  gl::texture::format        format  {gl::texture::format::rgba8};
+  GLsizei                    levels  {1};
+  GLsizei                    uploaded{0};
+
+  image_sink sink{
+    .allocate = [&](GLsizei w, GLsizei h, size_t s, gl::texture::format f) {
+      auto size = static_cast<size_t>(h) * s;
+
+      if (buffer && buffer->size() >= size) {
+        buffer->wait();
+      } else {
+        buffer.emplace(size);
+      }
+
+      levels = mipmap_levels(vec_cast<uint32_t>(vec2{w, h}), targets);
+
+      texture.emplace(gl::texture::immutable({.width = w, .height = h}, f, levels));
+      width  = w;
+      height = h;
+      stride = s;
+      format = f;
+
+      return buffer->data().first(size);
+    },
+
+    .rows_ready = [&](GLsizei first, GLsizei count) {
+      auto end = first + count;
+      if (static_cast<size_t>(end - uploaded) * stride < upload_granularity
+          && end < height) {
+        return;
+      }
+
+      buffer->upload(*texture, uploaded, {.width = width, .height = end - uploaded},
+          stride, format);
+      uploaded = end;
+    }
+  };
+
+  auto img = load_image(path, targets, sink);
+
+  if (!texture) {
+    return {
+      .texture       = to_texture(img, mipmap_levels(img_size(img), targets)),
+      .size          = img_size(img),
+      .original_size = img.original_size
+    };
+  }
+
+  if (uploaded < height) {
+    buffer->upload(*texture, uploaded, {.width = width, .height = height - uploaded},
+        stride, format);
+  }
+  buffer->finish();
+
+  if (levels > 1) {
+    texture->generate_mipmaps();
+  }
+
+  return {
+    .texture       = std::move(*texture),
+    .size          = img_size(img),
+    .original_size = img.original_size
+  };
+}
+
+
+
+
+
+vec2<float> distribution_scale(
+  config::scale_mode       scale_mode,
+  const wayland::geometry& geometry,
+  vec2<float>              size
+) {
+  auto physical_size = vec_cast<float>(geometry.physical_size());
+  auto s = div(size, physical_size);
+
+  switch (scale_mode) {
+    case config::scale_mode::zoom:
+      return div(physical_size * std::min(s.x(), s.y()), size);
+
+    case config::scale_mode::fit:
+      return div(physical_size * std::max(s.x(), s.y()), size);
+
+    case config::scale_mode::centered:
+      return div(physical_size, size);
+
+    case config::scale_mode::stretch:
+      return vec2{1.f};
+  }
+
+  logcerr::warn("unsupported image scale mode");
+  return vec2{1.f};
+}
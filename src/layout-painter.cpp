@@ -3,13 +3,26 @@
 #include "wallpablur/config/output.hpp"
 #include "wallpablur/gl/utils.hpp"
 #include "wallpablur/layout-painter.hpp"
+#include "wallpablur/pixel-region.hpp"
 #include "wallpablur/rectangle.hpp"
 #include "wallpablur/surface.hpp"
 #include "shader/shader.hpp"
 
 #include <algorithm>
 #include <array>
+#include <chrono>
+#include <cmath>
+#include <deque>
+#include <functional>
+#include <future>
+#include <iterator>
 #include <limits>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
 
 #include <gl/framebuffer.hpp>
 
@@ -18,36 +31,174 @@
 
 
 namespace {
-  using mat4 = std::array<GLfloat, 16>;
+  template<typename FNC, typename ...ARGS>
+  void invoke_append_color(FNC&& f, const config::color& c, ARGS&&... args) {
+    std::forward<FNC>(f)(std::forward<ARGS>(args)...,
+        c[0] * c[3], c[1] * c[3], c[2] * c[3], c[3]);
+  }
+
+
+
+
+
+  [[nodiscard]] std::array<GLfloat, 4> to_array(const rectangle& r) {
+    return {r.pos().x(), r.pos().y(), r.size().x(), r.size().y()};
+  }
+
+
+
+  // rectangles which are drawn with the same mesh and program in a single call
+  class rect_batch {
+    public:
+      void add(const rectangle& r, float radius = 0.f) {
+        add(r, std::span{&r, 1}, radius);
+      }
+
+      // only the parts `clips` of `r` are drawn, as one instance each
+      void add(
+          const rectangle&           r,
+          std::span<const rectangle> clips,
+          float                      radius    = 0.f,
+          float                      thickness = 0.f,
+          std::bitset<4>             sides     = {}
+      ) {
+        for (const auto& clip: clips) {
+          instances_.emplace_back(gl::rect_instance{
+            .rect      = to_array(r),
+            .clip      = to_array(clip),
+            .radius    = radius,
+            .thickness = thickness,
+            .sides     = static_cast<GLfloat>(sides.to_ulong()),
+            .unused    = 0.f
+          });
+        }
+      }
+
+
+
+      [[nodiscard]] bool empty() const { return instances_.empty(); }
+      [[nodiscard]] size_t size() const { return instances_.size(); }
+
+
+
+      void move_to(std::vector<gl::rect_instance>& output) {
+        output.insert(output.end(), instances_.begin(), instances_.end());
+        instances_.clear();
+      }
+
+
+
+      void draw(
+          const wayland::geometry&   geo,
+          const gl::instance_buffer& buffer,
+          const gl::mesh&            mesh
+      ) {
+        if (instances_.empty()) {
+          return;
+        }
 
+        glUniform2f(0, geo.logical_size().x(), geo.logical_size().y());
 
+        buffer.upload(instances_);
+        mesh.draw_instanced(static_cast<GLsizei>(instances_.size()));
 
-  constexpr mat4 mat4_unity {
-    1.f, 0.f, 0.f, 0.f,
-    0.f, 1.f, 0.f, 0.f,
-    0.f, 0.f, 1.f, 0.f,
-    0.f, 0.f, 0.f, 1.f
+        instances_.clear();
+      }
+
+
+
+    private:
+      std::vector<gl::rect_instance> instances_;
   };
 
 
 
+  template<typename FNC>
+  void draw_damaged(
+      const std::optional<damage_region>& damage,
+      const wayland::geometry&            geo,
+      FNC&&                               draw
+  ) {
+    if (!damage) {
+      draw();
+      return;
+    }
+
+    auto height = static_cast<GLint>(geo.physical_size().y());
+
+    glEnable(GL_SCISSOR_TEST);
 
+    for (const auto& rect: damage->rects()) {
+      glScissor(rect.x, height - rect.y - rect.height, rect.width, rect.height);
+      draw();
+    }
 
-  template<typename FNC, typename ...ARGS>
-  void invoke_append_color(FNC&& f, const config::color& c, ARGS&&... args) {
-    std::forward<FNC>(f)(std::forward<ARGS>(args)...,
-        c[0] * c[3], c[1] * c[3], c[2] * c[3], c[3]);
+    glDisable(GL_SCISSOR_TEST);
   }
 
 
 
 
+  // everything drawn in a frame, uploaded once and then replayed for every damaged
+  // rectangle with only the scissor changing in between
+  class draw_list {
+    public:
+      // `setup` runs again for every damaged rectangle, so it has to set all the state
+      // the instances of `batch` are drawn with
+      void add(rect_batch& batch, std::function<void()> setup) {
+        steps_.emplace_back(step{
+          .setup = std::move(setup),
+          .first = static_cast<GLuint>(instances_.size()),
+          .count = static_cast<GLsizei>(batch.size())
+        });
+
+        batch.move_to(instances_);
+      }
+
+      void add(std::function<void()> setup) {
+        rect_batch empty;
+        add(empty, std::move(setup));
+      }
+
+
+
+      void draw(
+          const std::optional<damage_region>& damage,
+          const wayland::geometry&            geo,
+          const gl::instance_buffer&          buffer,
+          const gl::mesh&                     mesh
+      ) const {
+        if (!instances_.empty()) {
+          buffer.upload(instances_);
+        }
+
+        draw_damaged(damage, geo, [&]() {
+          for (const auto& s: steps_) {
+            s.setup();
+
+            if (s.count > 0) {
+              glUniform2f(0, geo.logical_size().x(), geo.logical_size().y());
+              mesh.draw_instanced(s.count, s.first);
+            }
+          }
+        });
+      }
+
+
+
+    private:
+      struct step {
+        std::function<void()> setup;
+        GLuint                first{0};
+        GLsizei               count{0};
+      };
+
+      std::vector<gl::rect_instance> instances_;
+      std::vector<step>              steps_;
+  };
+
 
-  void draw_mesh(const wayland::geometry& geo, const rectangle& r, const gl::mesh& mesh) {
-    glUniformMatrix4fv(0, 1, GL_FALSE, r.to_matrix(geo.logical_size()).data());
 
-    mesh.draw();
-  }
 
 
 
@@ -97,9 +248,10 @@ namespace {
 
 
 
-  void set_border_uniforms(const config::border_effect& effect, float radius) {
-    glUniform1f(20, effect.exponent);
-    glUniform1f(21, 1.f + radius / effect.thickness);
+  void set_border_uniforms(const config::border_effect& effect) {
+    if (effect.foff != config::falloff::none) {
+      glUniform1f(20, effect.exponent);
+    }
     invoke_append_color(glUniform4f, effect.col, 10);
   }
 
@@ -126,82 +278,181 @@ namespace {
 
 
 
-  [[nodiscard]] std::array<rectangle, 4> border_rectangles(rectangle r, float t) {
-    auto&& s = r.size();
+  [[nodiscard]] const config::wallpaper* active_wallpaper(
+      const workspace&                   ws,
+      std::span<const config::wallpaper> wallpapers
+  ) {
+    for (const auto& wp: wallpapers) {
+      if (wp.condition.evaluate(ws)) {
+        return &wp;
+      }
+    }
 
-    return {
-      rectangle{r.pos() - vec2{0.f,     t}, {s.x(), t}, r.rot_cw90() + 0},
-      rectangle{r.pos() + vec2{s.x(), 0.f}, {t, s.y()}, r.rot_cw90() + 1},
-      rectangle{r.pos() + vec2{0.f, s.y()}, {s.x(), t}, r.rot_cw90() + 2},
-      rectangle{r.pos() - vec2{t,     0.f}, {t, s.y()}, r.rot_cw90() + 3},
-    };
+    return nullptr;
   }
 
-  [[nodiscard]] std::array<rectangle, 4> border_rectangles_in(rectangle r, float t) {
-    auto&& s = r.size();
 
-    return {
-      rectangle{r.pos(),                        {s.x(), t}, r.rot_cw90() + 2},
-      rectangle{r.pos() + vec2{s.x() - t, 0.f}, {t, s.y()}, r.rot_cw90() + 3},
-      rectangle{r.pos() + vec2{0.f, s.y() - t}, {s.x(), t}, r.rot_cw90() + 0},
-      rectangle{r.pos(),                        {t, s.y()}, r.rot_cw90() + 1},
-    };
-  }
 
 
 
-  [[nodiscard]] std::array<rectangle, 4> corner_rectangles(rectangle r, float t) {
-    auto&& s = r.size();
-    vec2 size{t};
+  // pixels which are completely covered by the opaque backgrounds of the surfaces, the
+  // backgrounds are drawn last, so nothing below them needs to be drawn
+  class occlusion {
+    public:
+      occlusion(
+          const workspace&         ws,
+          const config::wallpaper* active,
+          std::span<const float>   radii,
+          const wayland::geometry& geo
+      ) :
+        geometry_{geo}
+      {
+        // a background image is blended onto its color
+        if (active == nullptr || active->background.description.solid[3] < 1.f) {
+          return;
+        }
 
-    return {
-      rectangle{r.pos() + vec2{s.x(), -t}, size, r.rot_cw90() + 0},
-      rectangle{r.pos() + s,               size, r.rot_cw90() + 1},
-      rectangle{r.pos() + vec2{-t, s.y()}, size, r.rot_cw90() + 2},
-      rectangle{r.pos() - size,            size, r.rot_cw90() + 3},
-    };
-  }
+        for (size_t i = 0; i < ws.surfaces().size(); ++i) {
+          const auto& surf = ws.surfaces()[i];
+          if (!active->background.condition.evaluate(surf, ws)) {
+            continue;
+          }
 
+          auto rect   = surf.rect();
+          auto radius = std::min({radii[i], rect.size().x() / 2.f, rect.size().y() / 2.f});
 
+          // the rounded corners are left out
+          occluders_.emplace_back(i, inner_pixels(rectangle{
+              rect.pos() + vec2{radius, 0.f}, rect.size() - vec2{2.f * radius, 0.f}}));
+          occluders_.emplace_back(i, inner_pixels(rectangle{
+              rect.pos() + vec2{0.f, radius}, rect.size() - vec2{0.f, 2.f * radius}}));
+        }
+      }
 
-  [[nodiscard]] std::array<rectangle, 8> corner_rectangles_alt(rectangle r, float t) {
-    auto&& s = r.size();
-    vec2 size{t};
 
-    return {
-      rectangle{r.pos() + vec2{-t, 0.f},           size, r.rot_cw90() + 2},
-      rectangle{r.pos() + vec2{s.x(), 0.f} - size, size, r.rot_cw90() + 3},
-      rectangle{r.pos() + s - vec2{0.f, t},        size, r.rot_cw90() + 0},
-      rectangle{r.pos() + vec2{0.f, s.y()},        size, r.rot_cw90() + 1},
-
-      rectangle{r.pos() + vec2{s.x(), 0.f},        size, r.rot_cw90() + 1},
-      rectangle{r.pos() + s - vec2{t, 0.f},        size, r.rot_cw90() + 2},
-      rectangle{r.pos() + vec2{0.f, s.y()} - size, size, r.rot_cw90() + 3},
-      rectangle{r.pos() - vec2{0.f, t},            size, r.rot_cw90() + 0},
-    };
-  }
 
+      // parts of `rect` which are not hidden by the backgrounds of the surfaces with an
+      // index of at least `first`
+      [[nodiscard]] std::vector<rectangle> visible(
+          const rectangle& rect,
+          size_t           first = 0
+      ) const {
+        auto screen = geometry_.physical_size();
 
+        pixel_region region{intersection(outer_pixels(rect), pixel_rect{
+          .x      = 0,
+          .y      = 0,
+          .width  = static_cast<int32_t>(screen.x()),
+          .height = static_cast<int32_t>(screen.y())
+        })};
 
+        for (const auto& [index, occluder]: occluders_) {
+          if (index >= first) {
+            region.subtract(occluder);
+          }
+        }
 
+        auto scale = div(geometry_.logical_size(), vec_cast<float>(screen));
 
-  [[nodiscard]] const config::wallpaper* active_wallpaper(
-      const workspace&                   ws,
-      std::span<const config::wallpaper> wallpapers
-  ) {
-    for (const auto& wp: wallpapers) {
-      if (wp.condition.evaluate(ws)) {
-        return &wp;
+        std::vector<rectangle> output;
+        output.reserve(region.rects().size());
+
+        for (const auto& r: region.rects()) {
+          output.emplace_back(
+            mul(vec_cast<float>(vec2{r.x,     r.y}),      scale),
+            mul(vec_cast<float>(vec2{r.width, r.height}), scale)
+          );
+        }
+
+        return output;
+      }
+
+
+
+    private:
+      wayland::geometry                          geometry_;
+      std::vector<std::pair<size_t, pixel_rect>> occluders_;
+
+
+
+      [[nodiscard]] vec2<float> scale() const {
+        return div(vec_cast<float>(geometry_.physical_size()), geometry_.logical_size());
+      }
+
+      [[nodiscard]] static pixel_rect from_corners(vec2<float> min, vec2<float> max) {
+        auto x0 = static_cast<int32_t>(min.x());
+        auto y0 = static_cast<int32_t>(min.y());
+
+        return {
+          .x      = x0,
+          .y      = y0,
+          .width  = static_cast<int32_t>(max.x()) - x0,
+          .height = static_cast<int32_t>(max.y()) - y0
+        };
+      }
+
+      // pixels which are covered completely by `rect`
+      [[nodiscard]] pixel_rect inner_pixels(const rectangle& rect) const {
+        auto min = mul(rect.min(), scale());
+        auto max = mul(rect.max(), scale());
+
+        return from_corners({std::ceil(min.x()), std::ceil(min.y())},
+                            {std::floor(max.x()), std::floor(max.y())});
+      }
+
+      // pixels which are touched by `rect`
+      [[nodiscard]] pixel_rect outer_pixels(const rectangle& rect) const {
+        auto min = mul(rect.min(), scale());
+        auto max = mul(rect.max(), scale());
+
+        return from_corners({std::floor(min.x()), std::floor(min.y())},
+                            {std::ceil(max.x()), std::ceil(max.y())});
       }
+  };
+
+
+
+
+
+  void add_border_effect(
+      rect_batch&                  batch,
+      const config::border_effect& effect,
+      const surface&               surf,
+      float                        radius,
+      const occlusion&             occluded
+  ) {
+    auto sides = realize_sides(effect.sides, surf.flags());
+
+    if (sides.none()) {
+      return;
     }
 
-    return nullptr;
+    auto tile      = center_tile(surf.rect(), effect);
+    auto thickness = static_cast<float>(effect.thickness);
+
+    rectangle rect{tile.pos() - vec2{thickness}, tile.size() + vec2{2.f * thickness}};
+
+    batch.add(rect, occluded.visible(rect), radius, thickness, sides);
   }
 
 
 
 
 
+  [[nodiscard]] std::string border_fs(std::string_view falloff) {
+    return gl::insert_after_version(resources::border_fs(),
+        "#define " + std::string{falloff} + "\n");
+  }
+
+
+
+  // the fragment shaders of rounded rectangles share their inputs and distance function
+  [[nodiscard]] std::string with_rounded_rectangle(std::string_view source) {
+    return gl::insert_after_version(source, resources::rounded_rectangle_fs());
+  }
+
+
+
   [[nodiscard]] std::shared_ptr<egl::context> activate_context(
       std::shared_ptr<egl::context> ctx
   ) {
@@ -255,6 +506,19 @@ class layout_painter::radius_cache {
 
 
 
+    [[nodiscard]] std::vector<float> radii(const workspace& ws) const {
+      std::vector<float> output;
+      output.reserve(ws.surfaces().size());
+
+      for (const auto& surf: ws.surfaces()) {
+        output.emplace_back(radius(surf));
+      }
+
+      return output;
+    }
+
+
+
   private:
     using kv = std::pair<const surface*, float>;
 
@@ -283,8 +547,8 @@ class layout_painter::radius_cache {
 
 struct layout_painter::wallpaper_context {
   std::shared_ptr<egl::context> context;
+  gl::instance_buffer           instances;
   gl::mesh                      quad;
-  gl::mesh                      sector;
   gl::program                   solid_color_shader;
   GLint                         solid_color_color;
   gl::program                   solid_color_aa_shader;
@@ -293,7 +557,6 @@ struct layout_painter::wallpaper_context {
   GLint                         texture_alpha;
   gl::program                   texture_aa_shader;
   GLint                         texture_aa_alpha;
-  GLint                         aa_cutoff;
 
   enum class shader {
     border_step,
@@ -311,23 +574,18 @@ struct layout_painter::wallpaper_context {
 
   wallpaper_context(std::shared_ptr<egl::context> ctx) :
     context              {activate_context(std::move(ctx))},
-    quad                 {gl::create_quad()},
-    sector               {gl::create_sector(16)},
+    quad                 {gl::create_quad(&instances)},
     solid_color_shader   {resources::solid_color_vs(), resources::solid_color_fs()},
     solid_color_color    {solid_color_shader.uniform("color_rgba")},
-    solid_color_aa_shader{resources::solid_color_vs(),
-                          resources::solid_color_aa_inner_fs()},
-    solid_color_aa_color {solid_color_shader.uniform("color_rgba")},
+    solid_color_aa_shader{resources::rounded_rectangle_vs(),
+                          with_rounded_rectangle(resources::solid_color_aa_inner_fs())},
+    solid_color_aa_color {solid_color_aa_shader.uniform("color_rgba")},
     texture_shader       {resources::texture_vs(), resources::texture_fs()},
     texture_alpha        {texture_shader.uniform("alpha")},
-    texture_aa_shader    {resources::texture_vs(), resources::texture_aa_inner_fs()},
-    texture_aa_alpha     {texture_aa_shader.uniform("alpha")},
-    aa_cutoff            {texture_aa_shader.uniform("cutoff")}
-  {
-    if (aa_cutoff != solid_color_aa_shader.uniform("cutoff")) {
-      throw exception{"uniform mismatch cutoff"};
-    }
-  }
+    texture_aa_shader    {resources::rounded_rectangle_vs(),
+                          with_rounded_rectangle(resources::texture_aa_inner_fs())},
+    texture_aa_alpha     {texture_aa_shader.uniform("alpha")}
+  {}
 
   ~wallpaper_context() {
     context->make_current();
@@ -337,58 +595,24 @@ struct layout_painter::wallpaper_context {
 
 
 
-  void draw_rounded_rectangle(
-      const wayland::geometry& geo,
-      const rectangle&         rect,
-      float                    radius,
-      const gl::program&       shader,
-      const gl::program&       corner_shader
-  ) const {
-    radius = std::min({radius, rect.size().x(), rect.size().y()});
-
-    shader.use();
-
-    if (radius < std::numeric_limits<float>::epsilon()) {
-      draw_mesh(geo, rect, quad);
-      return;
-    }
-
-    auto center = rect;
-    center.inset(radius);
-
-    draw_mesh(geo, center, quad);
-
-    for (const auto& bord: border_rectangles(center, radius)) {
-      draw_mesh(geo, bord, quad);
-    }
-
-    corner_shader.use();
-    glUniform1f(aa_cutoff, 0.75f / radius);
-
-    for (const auto& corn: corner_rectangles(center, radius)) {
-      draw_mesh(geo, corn, quad);
-    }
-  }
-
-
-
-
-
-  void bind_effect_border(const config::border_effect& effect, float radius) const {
+  void bind_effect_border(const config::border_effect& effect) const {
     switch (effect.foff) {
       case config::falloff::none:
+        shader_cache.find_or_create(shader::border_step,
+            resources::border_vs(), border_fs("FALLOFF_STEP")).use();
+        set_border_uniforms(effect);
         break;
 
       case config::falloff::linear:
         shader_cache.find_or_create(shader::border_linear,
-            resources::border_vs(), resources::border_linear_fs()).use();
-        set_border_uniforms(effect, radius);
+            resources::border_vs(), border_fs("FALLOFF_LINEAR")).use();
+        set_border_uniforms(effect);
         break;
 
       case config::falloff::sinusoidal:
         shader_cache.find_or_create(shader::border_sinusoidal,
-            resources::border_vs(), resources::border_sinusoidal_fs()).use();
-        set_border_uniforms(effect, radius);
+            resources::border_vs(), border_fs("FALLOFF_SINUSOIDAL")).use();
+        set_border_uniforms(effect);
         break;
     }
   }
@@ -397,106 +621,57 @@ struct layout_painter::wallpaper_context {
 
 
 
-  void draw_sides(
-      const wayland::geometry& geo,
-      std::bitset<4>           sides,
-      rectangle                center,
-      float                    thickness
+  void draw_border_effect(
+    const config::border_effect& effect,
+    rect_batch&                  batch,
+    draw_list&                   list
   ) const {
-    auto borders    = border_rectangles(center, thickness);
-    auto borders_in = border_rectangles_in(center, thickness);
-
-    constexpr auto S = sides.size();
-
-    static_assert(borders.size() == S && borders_in.size() == S);
-    for (size_t side = 0; side < S; ++side) {
-      if (!sides[side]) {
-        continue;
-      }
-
-      draw_mesh(geo, borders[side], quad);                //NOLINT(*-constant-array-index)
-
-      if (!sides.all()) {
-        draw_mesh(geo, borders_in[side], quad);           //NOLINT(*-constant-array-index)
-      }
+    if (batch.empty()) {
+      return;
     }
 
-    auto corners     = corner_rectangles(center, thickness);
-    auto corners_alt = corner_rectangles_alt(center, thickness);
-
-    static_assert(corners.size() == S && corners_alt.size() == S * 2);
-    for (size_t side = 0; side < S; ++side) {
-      if (!sides[(side + S - 1) % S] && sides[side]) {
-        draw_mesh(geo, corners_alt[side], sector);        //NOLINT(*-constant-array-index)
-      }
-
-      if (sides[side] && !sides[(side + 1) % S]) {
-        draw_mesh(geo, corners_alt[side + S], sector);    //NOLINT(*-constant-array-index)
-      }
-
-      if (sides[side] || sides[(side + 1) % S]) {
-        draw_mesh(geo, corners[side], sector);            //NOLINT(*-constant-array-index)
-      }
-    }
+    list.add(batch, [this, &effect]() {
+      set_blend_mode(effect.blend);
+      bind_effect_border(effect);
+    });
   }
 
 
 
 
 
-  void draw_border_effect(
-    const wayland::geometry&     geo,
-    const config::border_effect& effect,
-    const surface&               surf,
-    float                        radius
+  void draw_wallpaper(
+      const wayland::geometry& geo,
+      const config::wallpaper& wp,
+      const occlusion&         occluded,
+      draw_list&               list
   ) const {
-    auto sides = realize_sides(effect.sides, surf.flags());
-
-    if (sides.none()) {
-      return;
-    }
-
-    set_blend_mode(effect.blend);
-
-    auto center = center_tile(surf.rect(), effect);
-    center.inset(radius);
-
-    if (sides.all()) {
-      solid_color_shader.use();
-      invoke_append_color(glUniform4f, effect.col, solid_color_color);
-      draw_mesh(geo, center, quad);
-    }
-
-    bind_effect_border(effect, radius);
+    rectangle screen{{0.f, 0.f}, geo.logical_size()};
 
-    float thickness = effect.thickness + radius;
-    if (thickness < std::numeric_limits<float>::epsilon()) {
+    auto visible = occluded.visible(screen);
+    if (visible.empty()) {
       return;
     }
 
-    draw_sides(geo, sides, center, thickness);
-
-    set_blend_mode();
-  }
-
-
-
-
-
-  void draw_wallpaper(const config::wallpaper& wp) const {
     if (wp.description.realization) {
-      glClearColor(0.f, 0.f, 0.f, 0.f);
-      glClear(GL_COLOR_BUFFER_BIT);
+      rect_batch batch;
+      batch.add(screen, visible);
 
-      texture_shader.use();
-      glUniform1f(texture_alpha, 1.f);
-      glUniformMatrix4fv(0, 1, GL_FALSE, mat4_unity.data());
+      list.add(batch, [this, &wp]() {
+        glClearColor(0.f, 0.f, 0.f, 0.f);
+        glClear(GL_COLOR_BUFFER_BIT);
 
-      wp.description.realization->bind();
-      quad.draw();
+        set_blend_mode();
+        texture_shader.use();
+        glUniform1f(texture_alpha, 1.f);
+
+        wp.description.realization->bind();
+      });
     } else {
-      invoke_append_color(glClearColor, wp.description.solid);
-      glClear(GL_COLOR_BUFFER_BIT);
+      list.add([&wp]() {
+        invoke_append_color(glClearColor, wp.description.solid);
+        glClear(GL_COLOR_BUFFER_BIT);
+      });
     }
   }
 
@@ -505,17 +680,24 @@ struct layout_painter::wallpaper_context {
 
 
   void draw_surface_effects(
-      const wayland::geometry&               geo,
       std::span<const config::border_effect> border_effects,
       const workspace&                       ws,
-      const radius_cache&                    radii
+      const radius_cache&                    radii,
+      const occlusion&                       occluded,
+      draw_list&                             list
   ) const {
+    rect_batch batch;
+
+    // instances are drawn in order, so replaced pixels still end up with the effect of
+    // the topmost surface
     for (const auto& be: border_effects) {
       for (const auto& surface: ws.surfaces()) {
         if (be.condition.evaluate(surface, ws)) {
-          draw_border_effect(geo, be, surface, radii.radius(surface));
+          add_border_effect(batch, be, surface, radii.radius(surface), occluded);
         }
       }
+
+      draw_border_effect(be, batch, list);
     }
   }
 
@@ -523,27 +705,17 @@ struct layout_painter::wallpaper_context {
 
 
 
-  [[nodiscard]] std::pair<const gl::program*, const gl::program*>
-  setup_aa_shader(const config::background& bg) const {
+  void setup_aa_shader(const config::background& bg) const {
     if (bg.description.realization) {
       texture_aa_shader.use();
       glUniform1f(texture_aa_alpha, 1.f);
 
-      texture_shader.use();
-      glUniform1f(texture_alpha, 1.f);
-
       bg.description.realization->bind();
-
-      return {&texture_shader, &texture_aa_shader};
+      return;
     }
 
     solid_color_aa_shader.use();
     invoke_append_color(glUniform4f, bg.description.solid, solid_color_aa_color);
-
-    solid_color_shader.use();
-    invoke_append_color(glUniform4f, bg.description.solid, solid_color_color);
-
-    return {&solid_color_shader, &solid_color_aa_shader};
   }
 
 
@@ -551,38 +723,49 @@ struct layout_painter::wallpaper_context {
 
 
   void draw_background(
-      const wayland::geometry&  geo,
       const config::background& bg,
       const workspace&          ws,
-      const radius_cache&       radii
+      const radius_cache&       radii,
+      const occlusion&          occluded,
+      draw_list&                list
   ) const {
-    auto [shader, corner_shader] = setup_aa_shader(bg);
+    rect_batch batch;
+
+    for (size_t i = 0; i < ws.surfaces().size(); ++i) {
+      const auto& surface = ws.surfaces()[i];
 
-    for (const auto& surface: ws.surfaces()) {
       if (bg.condition.evaluate(surface, ws)) {
-        draw_rounded_rectangle(geo, surface.rect(), radii.radius(surface),
-            *shader, *corner_shader);
+        batch.add(surface.rect(), occluded.visible(surface.rect(), i + 1),
+            radii.radius(surface));
       }
     }
-  }
 
+    if (batch.empty()) {
+      return;
+    }
 
+    list.add(batch, [this, &bg]() {
+      set_blend_mode();
+      setup_aa_shader(bg);
+    });
+  }
 
 
 
-  void set_buffer_alpha(float alpha) const {
-    solid_color_shader.use();
-    glUniform4f(solid_color_color, 0, 0, 0, 0);
 
-    glUniformMatrix4fv(0, 1, GL_FALSE, mat4_unity.data());
 
-    glEnable(GL_BLEND);
-    glBlendColor(alpha, alpha, alpha, alpha);
-    glBlendFunc(GL_CONSTANT_COLOR, GL_CONSTANT_COLOR);
+  void set_buffer_alpha(const wayland::geometry& geo, float alpha, draw_list& list) const {
+    rect_batch batch;
+    batch.add(rectangle{{0.f, 0.f}, geo.logical_size()});
 
-    quad.draw();
+    list.add(batch, [this, alpha]() {
+      solid_color_shader.use();
+      glUniform4f(solid_color_color, 0, 0, 0, 0);
 
-    set_blend_mode();
+      glEnable(GL_BLEND);
+      glBlendColor(alpha, alpha, alpha, alpha);
+      glBlendFunc(GL_CONSTANT_COLOR, GL_CONSTANT_COLOR);
+    });
   }
 };
 
@@ -592,10 +775,10 @@ struct layout_painter::wallpaper_context {
 
 struct layout_painter::clipping_context {
   std::shared_ptr<egl::context> context;
+  gl::instance_buffer           instances;
   gl::mesh                      quad;
   gl::program                   texture_aa_shader;
   GLint                         texture_aa_shader_alpha;
-  GLint                         texture_aa_shader_cutoff;
 
   gl::texture                   cached;
   wayland::geometry             cached_size;
@@ -609,10 +792,10 @@ struct layout_painter::clipping_context {
 
   clipping_context(std::shared_ptr<egl::context> ctx) :
     context                 {activate_context(std::move(ctx))},
-    quad                    {gl::create_quad()},
-    texture_aa_shader       {resources::texture_vs(), resources::texture_aa_outer_fs()},
-    texture_aa_shader_alpha {texture_aa_shader.uniform("alpha")},
-    texture_aa_shader_cutoff{texture_aa_shader.uniform("cutoff")}
+    quad                    {gl::create_quad(&instances)},
+    texture_aa_shader       {resources::rounded_rectangle_vs(),
+                             with_rounded_rectangle(resources::texture_aa_outer_fs())},
+    texture_aa_shader_alpha {texture_aa_shader.uniform("alpha")}
   {}
 
   ~clipping_context() {
@@ -623,26 +806,278 @@ struct layout_painter::clipping_context {
 
 
 
-  void draw_corner_clipping(
-      const wayland::geometry& geo,
-      const rectangle&         rect,
-      float                    radius
-  ) const {
-    radius = std::min({radius, rect.size().x(), rect.size().y()});
-
-    if (radius < std::numeric_limits<float>::epsilon()) {
+  // everything but the corners and a band of `margin` along the edges is drawn fully
+  // transparent, so only those parts of `rect` are covered
+  static void add_corner_clipping(
+      rect_batch&      batch,
+      const rectangle& rect,
+      float            radius,
+      float            margin
+  ) {
+    if (radius < std::numeric_limits<float>::epsilon() || rect.empty()) {
       return;
     }
 
-    glUniform1f(texture_aa_shader_cutoff, 0.75f / radius);
+    auto half   = 0.5f * rect.size();
+    auto corner = min(vec2{std::min({radius, half.x(), half.y()}) + margin}, half);
+    auto band   = min(vec2{margin}, half);
 
-    auto center = rect;
-    center.inset(radius);
+    auto x0 = rect.min().x();
+    auto x1 = x0 + corner.x();
+    auto x3 = rect.max().x();
+    auto x2 = std::max(x1, x3 - corner.x());
+
+    auto y0 = rect.min().y();
+    auto y1 = y0 + corner.y();
+    auto y3 = rect.max().y();
+    auto y2 = std::max(y1, y3 - corner.y());
+
+    auto from_corners = [](float left, float top, float right, float bottom) {
+      return rectangle{{left, top}, {right - left, bottom - top}};
+    };
 
-    for (const auto& corn: corner_rectangles(center, radius)) {
-      draw_mesh(geo, corn, quad);
+    std::array parts {
+      from_corners(x0, y0, x1, y1),
+      from_corners(x2, y0, x3, y1),
+      from_corners(x0, y2, x1, y3),
+      from_corners(x2, y2, x3, y3),
+
+      from_corners(x1,            y0,            x2,            y0 + band.y()),
+      from_corners(x1,            y3 - band.y(), x2,            y3),
+      from_corners(x0,            y1,            x0 + band.x(), y2),
+      from_corners(x3 - band.x(), y1,            x3,            y2)
+    };
+
+    std::vector<rectangle> clips;
+    std::ranges::copy_if(parts, std::back_inserter(clips),
+        [](const rectangle& part) { return !part.empty(); });
+
+    batch.add(rect, clips, radius);
+  }
+};
+
+
+
+
+
+namespace {
+  // everything which decides what a surface adds to the wallpaper
+  struct surface_footprint {
+    rectangle                   rect;
+    float                       radius    {0.f};
+    std::vector<std::bitset<4>> sides;
+    bool                        background{false};
+
+    pixel_rect                  bounds;
+
+    bool operator==(const surface_footprint&) const = default;
+  };
+
+
+
+  struct frame_state {
+    wayland::geometry        geometry;
+    const config::wallpaper* wallpaper      {nullptr};
+    uint64_t                 texture_version{0};
+    float                    alpha          {1.f};
+
+    bool operator==(const frame_state&) const = default;
+  };
+
+
+
+  [[nodiscard]] pixel_rect to_pixels(const rectangle& rect, const wayland::geometry& geo) {
+    auto scale = div(vec_cast<float>(geo.physical_size()), geo.logical_size());
+
+    auto min = mul(rect.min(), scale);
+    auto max = mul(rect.max(), scale);
+
+    // antialiased edges may bleed into the neighboring pixels
+    auto x0 = static_cast<int32_t>(std::floor(min.x())) - 1;
+    auto y0 = static_cast<int32_t>(std::floor(min.y())) - 1;
+    auto x1 = static_cast<int32_t>(std::ceil (max.x())) + 1;
+    auto y1 = static_cast<int32_t>(std::ceil (max.y())) + 1;
+
+    return {.x = x0, .y = y0, .width = x1 - x0, .height = y1 - y0};
+  }
+
+
+
+  [[nodiscard]] pixel_rect bounds(const pixel_rect& lhs, const pixel_rect& rhs) {
+    if (lhs.empty()) {
+      return rhs;
+    }
+
+    auto x = std::min(lhs.x, rhs.x);
+    auto y = std::min(lhs.y, rhs.y);
+
+    return {
+      .x      = x,
+      .y      = y,
+      .width  = std::max(lhs.x + lhs.width,  rhs.x + rhs.width)  - x,
+      .height = std::max(lhs.y + lhs.height, rhs.y + rhs.height) - y
+    };
+  }
+
+
+
+  [[nodiscard]] std::vector<surface_footprint> footprints(
+      const workspace&                       ws,
+      std::span<const config::border_effect> border_effects,
+      const config::wallpaper*               active,
+      std::span<const float>                 radii,
+      const wayland::geometry&               geo
+  ) {
+    std::vector<surface_footprint> output;
+    output.reserve(ws.surfaces().size());
+
+    for (size_t i = 0; i < ws.surfaces().size(); ++i) {
+      const auto& surf = ws.surfaces()[i];
+
+      surface_footprint footprint{
+        .rect       = surf.rect(),
+        .radius     = radii[i],
+        .sides      = {},
+        .background = active != nullptr && active->background.condition.evaluate(surf, ws),
+        .bounds     = {}
+      };
+
+      if (footprint.background) {
+        footprint.bounds = to_pixels(surf.rect(), geo);
+      }
+
+      for (const auto& effect: border_effects) {
+        std::bitset<4> sides;
+
+        if (effect.condition.evaluate(surf, ws)) {
+          sides = realize_sides(effect.sides, surf.flags());
+        }
+
+        if (sides.any()) {
+          auto tile      = center_tile(surf.rect(), effect);
+          auto thickness = static_cast<float>(effect.thickness);
+
+          footprint.bounds = bounds(footprint.bounds, to_pixels(rectangle{
+              tile.pos()  - vec2{thickness},
+              tile.size() + vec2{2.f * thickness}}, geo));
+        }
+
+        footprint.sides.emplace_back(sides);
+      }
+
+      output.emplace_back(std::move(footprint));
     }
+
+    return output;
   }
+
+
+
+  // pixels change where a surface appeared, disappeared or changed, and where surfaces
+  // which are drawn on top of each other swapped their order
+  [[nodiscard]] damage_region difference(
+      const std::vector<surface_footprint>& previous,
+      const std::vector<surface_footprint>& current
+  ) {
+    damage_region damage;
+
+    std::vector<bool>   matched(previous.size(), false);
+    std::vector<size_t> order;
+    std::vector<size_t> order_index;
+
+    for (size_t i = 0; i < current.size(); ++i) {
+      size_t j = 0;
+      for (; j < previous.size(); ++j) {
+        if (!matched[j] && previous[j] == current[i]) {
+          break;
+        }
+      }
+
+      if (j == previous.size()) {
+        damage.add(current[i].bounds);
+        continue;
+      }
+
+      matched[j] = true;
+      order.emplace_back(j);
+      order_index.emplace_back(i);
+    }
+
+    for (size_t j = 0; j < previous.size(); ++j) {
+      if (!matched[j]) {
+        damage.add(previous[j].bounds);
+      }
+    }
+
+    auto sorted = order;
+    std::ranges::sort(sorted);
+
+    for (size_t k = 0; k < order.size(); ++k) {
+      if (order[k] != sorted[k]) {
+        damage.add(current[order_index[k]].bounds);
+      }
+    }
+
+    return damage;
+  }
+}
+
+
+
+class layout_painter::damage_tracker {
+  public:
+    // buffers older than this are redrawn completely
+    static constexpr EGLint max_buffer_age{4};
+
+
+
+    [[nodiscard]] std::optional<damage_region> update(
+        const frame_state&             state,
+        std::vector<surface_footprint> footprints,
+        EGLint                         buffer_age
+    ) {
+      std::optional<damage_region> damage;
+
+      if (valid_ && state == state_) {
+        damage = difference(footprints_, footprints);
+        damage->clip(state.geometry.physical_size());
+      }
+
+      valid_      = true;
+      state_      = state;
+      footprints_ = std::move(footprints);
+
+      auto repair = damage;
+
+      if (buffer_age <= 0 || std::cmp_greater(buffer_age - 1, history_.size())) {
+        repair.reset();
+      }
+
+      for (EGLint i = 0; repair && i < buffer_age - 1; ++i) {
+        if (const auto& previous = history_[i]) {
+          repair->add(*previous);
+        } else {
+          repair.reset();
+        }
+      }
+
+      history_.emplace_front(std::move(damage));
+      if (std::cmp_greater_equal(history_.size(), max_buffer_age)) {
+        history_.pop_back();
+      }
+
+      return repair;
+    }
+
+
+
+  private:
+    bool                                     valid_{false};
+    frame_state                              state_;
+    std::vector<surface_footprint>           footprints_;
+
+    // damage of the most recent frames, empty for frames which were redrawn completely
+    std::deque<std::optional<damage_region>> history_;
 };
 
 
@@ -650,9 +1085,18 @@ struct layout_painter::clipping_context {
 
 
 layout_painter::layout_painter(config::output config) :
+  layout_painter{std::move(config), app().texture_provider()}
+{}
+
+layout_painter::layout_painter(
+    config::output                    config,
+    std::shared_ptr<texture_provider> provider
+) :
   config_             {std::move(config)},
-  texture_provider_   {app().texture_provider()},
-  radius_cache_       {std::make_unique<radius_cache>(std::move(config_.rounded_corners))}
+  texture_provider_   {std::move(provider)},
+  radius_cache_       {std::make_unique<radius_cache>(std::move(config_.rounded_corners))},
+  wallpaper_damage_   {std::make_unique<damage_tracker>()},
+  cache_damage_       {std::make_unique<damage_tracker>()}
 {}
 
 layout_painter::layout_painter(layout_painter&&) noexcept = default;
@@ -675,6 +1119,19 @@ void layout_painter::set_clipping_context(std::shared_ptr<egl::context> context)
 
 
 
+namespace {
+  void request_realization(
+      config::brush&           brush,
+      texture_provider&        provider,
+      const wayland::geometry& geometry
+  ) {
+    brush.source_version      = provider.source_version(brush);
+    brush.pending_realization = provider.get(geometry, brush);
+  }
+}
+
+
+
 void layout_painter::update_geometry(const wayland::geometry& geometry) {
   if (geometry == geometry_) {
     return;
@@ -687,56 +1144,212 @@ void layout_painter::update_geometry(const wayland::geometry& geometry) {
 
 
 
+  std::vector<const config::brush*> brushes;
+  for (const auto& wp: config_.wallpapers) {
+    brushes.emplace_back(&wp.description);
+    brushes.emplace_back(&wp.background.description);
+  }
+  texture_provider_->prepare(geometry, brushes);
+
   for (auto& wp: config_.wallpapers) {
     if (wp.description.fgraph) {
-      wp.description.realization = texture_provider_->get(geometry, wp.description);
+      request_realization(wp.description, *texture_provider_, geometry);
+    }
+
+    if (wp.background.description.fgraph) {
+      request_realization(wp.background.description, *texture_provider_, geometry);
+    }
+  }
+}
+
+
+
+
+
+namespace {
+  [[nodiscard]] bool resolve_pending(
+      config::brush&   brush,
+      std::string_view output,
+      std::string_view type
+  ) {
+    if (!brush.pending_realization.valid() ||
+        brush.pending_realization.wait_for(std::chrono::seconds{0})
+          != std::future_status::ready) {
+      return false;
+    }
 
-      if (!wp.description.realization) {
-        logcerr::warn("{}: retrieved empty wallpaper image", config_.name);
+    auto realization = brush.pending_realization.get();
+    brush.pending_realization = {};
+
+    if (!realization) {
+      logcerr::warn("{}: retrieved empty {} image", output, type);
+
+      // a reloaded image failed, keep showing the previous version
+      if (brush.realization) {
+        return false;
       }
     }
 
-    if (wp.background.description.fgraph) {
-      wp.background.description.realization
-        = texture_provider_->get(geometry, wp.background.description);
+    brush.realization = std::move(realization);
+
+    return true;
+  }
+
+
+
+  [[nodiscard]] bool release_realization(config::brush& brush) {
+    if (brush.pending_realization.valid() &&
+        brush.pending_realization.wait_for(std::chrono::seconds{0})
+          == std::future_status::ready) {
+      brush.pending_realization = {};
+      brush.realization_released = true;
+    }
+
+    if (!brush.realization) {
+      return false;
+    }
+
+    brush.realization.reset();
+    brush.realization_released = true;
+
+    return true;
+  }
 
-      if (!wp.background.description.realization) {
-        logcerr::warn("{}: retrieved empty background image", config_.name);
+
+
+  void request_released(
+      config::brush&           brush,
+      texture_provider&        provider,
+      const wayland::geometry& geometry
+  ) {
+    if (!brush.realization_released || brush.pending_realization.valid()) {
+      return;
+    }
+
+    request_realization(brush, provider, geometry);
+    brush.realization_released = false;
+  }
+
+
+
+  [[nodiscard]] bool outdated(const config::brush& brush, texture_provider& provider) {
+    return brush.fgraph && !brush.realization_released
+      && !brush.pending_realization.valid()
+      && brush.source_version != provider.source_version(brush);
+  }
+}
+
+
+
+bool layout_painter::update_textures(const workspace& ws) {
+  bool changed {false};
+  bool released{false};
+
+  texture_provider_->reload_changed_sources();
+
+  std::vector<config::brush*> reload;
+
+  const auto* active = active_wallpaper(ws, config_.wallpapers);
+
+  for (auto& wp: config_.wallpapers) {
+    for (auto [brush, type]: {std::pair{&wp.description,            "wallpaper"},
+                              std::pair{&wp.background.description, "background"}}) {
+      if (&wp != active) {
+        // only displayed textures are kept alive, so that the texture_provider may
+        // evict the others if it runs out of memory
+        released = release_realization(*brush) || released;
+        continue;
+      }
+
+      request_released(*brush, *texture_provider_, geometry_);
+      changed = resolve_pending(*brush, config_.name, type) || changed;
+
+      if (outdated(*brush, *texture_provider_)) {
+        reload.emplace_back(brush);
       }
     }
   }
 
+  if (!reload.empty()) {
+    logcerr::verbose("{}: regenerating {} changed image(s)", config_.name, reload.size());
+
+    texture_provider_->prepare(geometry_, reload);
+
+    // the current realization is displayed until the new one is ready
+    for (auto* brush: reload) {
+      request_realization(*brush, *texture_provider_, geometry_);
+    }
+  }
+
+  if (changed || released) {
+    texture_provider_->cleanup();
+  }
+
+  if (changed) {
+    texture_version_++;
+  }
+
+  return changed;
+}
+
+
+
+
 
+void layout_painter::wait_for_textures(const workspace& ws) const {
+  const auto* active = active_wallpaper(ws, config_.wallpapers);
+  if (active == nullptr) {
+    return;
+  }
 
-  texture_provider_->cleanup();
+  for (const auto* brush: {&active->description, &active->background.description}) {
+    if (brush->pending_realization.valid()) {
+      brush->pending_realization.wait();
+    }
+  }
 }
 
 
 
 
 
-void layout_painter::draw_wallpaper(const workspace& ws, uint64_t id) const {
+void layout_painter::draw_wallpaper(
+    const workspace&                    ws,
+    uint64_t                            id,
+    float                               alpha,
+    const std::optional<damage_region>& damage
+) const {
   logcerr::debug("{}: drawing wallpaper", config_.name);
 
   glViewport(0, 0, geometry_.physical_size().x(), geometry_.physical_size().y());
 
-  set_blend_mode();
-
   const auto* active = active_wallpaper(ws, config_.wallpapers);
 
+  radius_cache_->update(ws, id);
+
+  occlusion occluded{ws, active, radius_cache_->radii(ws), geometry_};
+
+  draw_list list;
+
   if (active != nullptr) {
-    wallpaper_context_->draw_wallpaper(*active);
+    wallpaper_context_->draw_wallpaper(geometry_, *active, occluded, list);
   }
 
-  radius_cache_->update(ws, id);
-
-  wallpaper_context_->draw_surface_effects(geometry_, config_.border_effects, ws,
-      *radius_cache_);
+  wallpaper_context_->draw_surface_effects(config_.border_effects, ws, *radius_cache_,
+      occluded, list);
 
   if (active != nullptr) {
-    wallpaper_context_->draw_background(geometry_, active->background, ws,
-        *radius_cache_);
+    wallpaper_context_->draw_background(active->background, ws, *radius_cache_,
+        occluded, list);
   }
+
+  if (alpha < 254.f / 255.f) {
+    wallpaper_context_->set_buffer_alpha(geometry_, alpha, list);
+  }
+
+  list.draw(damage, geometry_, wallpaper_context_->instances, wallpaper_context_->quad);
+
+  set_blend_mode();
 }
 
 
@@ -755,6 +1368,7 @@ void layout_painter::update_cache(const workspace& ws, uint64_t id) const {
   }
 
   bool requires_update{false};
+  bool recreated      {false};
 
   if (clipping_context_->cached_workspace_id != id) {
     requires_update = true;
@@ -765,6 +1379,7 @@ void layout_painter::update_cache(const workspace& ws, uint64_t id) const {
 
   if (!clipping_context_->cached || clipping_context_->cached_size != geometry_) {
     requires_update = true;
+    recreated       = true;
     clipping_context_->cached = gl::texture(geometry_.physical_size().x(),
                                             geometry_.physical_size().y());
 
@@ -778,12 +1393,47 @@ void layout_painter::update_cache(const workspace& ws, uint64_t id) const {
 
   logcerr::debug("{}: update cache", config_.name);
 
+  radius_cache_->update(ws, id);
+  auto damage = update_damage(*cache_damage_, ws, 1.f, recreated ? 0 : 1);
+
   gl::framebuffer fb{clipping_context_->cached};
   auto lock = fb.bind();
 
   glViewport(0, 0, geometry_.physical_size().x(), geometry_.physical_size().y());
 
-  draw_wallpaper(ws, id);
+  draw_wallpaper(ws, id, 1.f, damage);
+}
+
+
+
+
+
+std::optional<damage_region> layout_painter::update_damage(
+    damage_tracker&  tracker,
+    const workspace& ws,
+    float            alpha,
+    EGLint           buffer_age
+) const {
+  auto radii = radius_cache_->radii(ws);
+  const auto* active = active_wallpaper(ws, config_.wallpapers);
+
+  auto damage = tracker.update(
+    frame_state{
+      .geometry        = geometry_,
+      .wallpaper       = active,
+      .texture_version = texture_version_,
+      .alpha           = alpha
+    },
+    footprints(ws, config_.border_effects, active, radii, geometry_),
+    buffer_age
+  );
+
+  if (damage) {
+    logcerr::debug("{}: redrawing {} of {} pixels", config_.name, damage->area(),
+        geometry_.physical_size().x() * geometry_.physical_size().y());
+  }
+
+  return damage;
 }
 
 
@@ -799,38 +1449,52 @@ void layout_painter::render_clear() {
 
 
 
-void layout_painter::render_wallpaper(const workspace& ws, float a, uint64_t id) const {
+std::optional<damage_region> layout_painter::render_wallpaper(
+    const workspace& ws,
+    float            a,
+    uint64_t         id
+) const {
   logcerr::debug("{}: rendering wallpaper {:#}, alpha = {}", config_.name,
       geometry_.physical_size(), a);
 
   if (!wallpaper_context_) {
     logcerr::warn("{}: trying to render wallpaper without context", config_.name);
-    return;
+    return {};
+  }
+
+  if (clipping_context_) {
+    update_cache(ws, id);
   }
 
   wallpaper_context_->context->make_current();
 
+  radius_cache_->update(ws, id);
+  auto damage = update_damage(*wallpaper_damage_, ws, a,
+      wallpaper_context_->context->buffer_age());
+
   set_blend_mode();
 
   if (clipping_context_) {
-    update_cache(ws, id);
+    rect_batch batch;
+    batch.add(rectangle{{0.f, 0.f}, geometry_.logical_size()});
 
-    render_clear();
+    draw_list list;
+    list.add(batch, [&]() {
+      render_clear();
 
-    wallpaper_context_->texture_shader.use();
-    glUniform1f(wallpaper_context_->texture_alpha, a);
-    glUniformMatrix4fv(0, 1, GL_FALSE, mat4_unity.data());
+      wallpaper_context_->texture_shader.use();
+      glUniform1f(wallpaper_context_->texture_alpha, a);
 
-    clipping_context_->cached.bind();
-    wallpaper_context_->quad.draw();
+      clipping_context_->cached.bind();
+    });
 
-  } else {
-    draw_wallpaper(ws, id);
+    list.draw(damage, geometry_, wallpaper_context_->instances, wallpaper_context_->quad);
 
-    if (a < 254.f / 255.f) {
-      wallpaper_context_->set_buffer_alpha(a);
-    }
+  } else {
+    draw_wallpaper(ws, id, a, damage);
   }
+
+  return damage;
 }
 
 
@@ -859,10 +1523,18 @@ void layout_painter::render_clipping(const workspace& ws, float a, uint64_t id)
 
   clipping_context_->cached.bind();
 
+  // the antialiased edges reach up to one physical pixel into a surface
+  auto pixel  = div(geometry_.logical_size(), vec_cast<float>(geometry_.physical_size()));
+  auto margin = std::max(pixel.x(), pixel.y());
+
+  rect_batch surfaces;
+
   for (const auto& surface: ws.surfaces()) {
-    clipping_context_->draw_corner_clipping(geometry_, surface.rect(),
-        radius_cache_->radius(surface));
+    clipping_context::add_corner_clipping(surfaces, surface.rect(),
+        radius_cache_->radius(surface), margin);
   }
+
+  surfaces.draw(geometry_, clipping_context_->instances, clipping_context_->quad);
 }
 
 
@@ -0,0 +1,213 @@
+#include "wallpablur/exception.hpp"
+#include "wallpablur/image.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <fstream>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <vector>
+
+#include <logcerr/log.hpp>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+
+
+namespace {
+  constexpr std::array<char, 8> farbfeld_magic {'f', 'a', 'r', 'b', 'f', 'e', 'l', 'd'};
+  constexpr size_t              header_size    {16};
+  constexpr size_t              bytes_per_pixel{8};
+
+
+
+  class file_descriptor {
+    public:
+      explicit file_descriptor(const std::filesystem::path& path) :
+        fd_{open(path.c_str(), O_RDONLY | O_CLOEXEC)} // NOLINT(*vararg)
+      {}
+
+      file_descriptor(const file_descriptor&) = delete;
+      file_descriptor(file_descriptor&&)      = delete;
+      file_descriptor& operator=(const file_descriptor&) = delete;
+      file_descriptor& operator=(file_descriptor&&)      = delete;
+
+      ~file_descriptor() {
+        if (fd_ >= 0) {
+          close(fd_);
+        }
+      }
+
+      [[nodiscard]] int get() const { return fd_; }
+
+
+
+    private:
+      int fd_;
+  };
+
+
+
+  class mapping {
+    public:
+      mapping(void* data, size_t size) :
+        data_{data},
+        size_{size}
+      {}
+
+      mapping(const mapping&) = delete;
+      mapping(mapping&&)      = delete;
+      mapping& operator=(const mapping&) = delete;
+      mapping& operator=(mapping&&)      = delete;
+
+      ~mapping() {
+        munmap(data_, size_);
+      }
+
+      [[nodiscard]] std::span<const std::byte> bytes() const {
+        return {static_cast<const std::byte*>(data_), size_};
+      }
+
+
+
+    private:
+      void*  data_;
+      size_t size_;
+  };
+
+
+
+  [[nodiscard]] uint32_t read_big_endian(std::span<const std::byte, 4> bytes) {
+    uint32_t value{0};
+    for (auto b: bytes) {
+      value = (value << 8u) | static_cast<uint32_t>(b);
+    }
+    return value;
+  }
+
+
+
+  // size of the pixel data, if the header describes an image which fits into a texture
+  // and into memory
+  [[nodiscard]] std::optional<size_t> checked_pixel_bytes(uint32_t width, uint32_t height) {
+    constexpr auto max_extent = static_cast<uint32_t>(std::numeric_limits<GLsizei>::max());
+
+    if (width == 0 || height == 0 || width > max_extent || height > max_extent) {
+      return {};
+    }
+
+    auto stride = static_cast<size_t>(width) * bytes_per_pixel;
+    if (height > (std::numeric_limits<size_t>::max() - header_size) / stride) {
+      return {};
+    }
+
+    return stride * height;
+  }
+
+
+
+  template<typename Output>
+  void write_big_endian(Output& out, uint32_t value, size_t bytes) {
+    for (size_t i = bytes; i-- > 0;) {
+      *out++ = static_cast<char>((value >> (8 * i)) & 0xffu);
+    }
+  }
+}
+
+
+
+std::optional<image> map_image(const std::filesystem::path& path) {
+  file_descriptor fd{path};
+  if (fd.get() < 0) {
+    return {};
+  }
+
+  std::array<char, header_size> header{};
+  if (pread(fd.get(), header.data(), header.size(), 0) != header_size
+      || !std::equal(farbfeld_magic.begin(), farbfeld_magic.end(), header.begin())) {
+    return {};
+  }
+
+  auto header_bytes = std::as_bytes(std::span{header});
+  auto width  = read_big_endian(header_bytes.subspan<8, 4>());
+  auto height = read_big_endian(header_bytes.subspan<12, 4>());
+
+  auto pixel_bytes = checked_pixel_bytes(width, height);
+  auto file_size   = lseek(fd.get(), 0, SEEK_END);
+
+  if (!pixel_bytes || file_size < 0
+      || static_cast<size_t>(file_size) < header_size + *pixel_bytes) {
+    logcerr::warn("{} is not a valid farbfeld file", path.string());
+    return {};
+  }
+
+  auto size = header_size + *pixel_bytes;
+  void* data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd.get(), 0);
+  if (data == MAP_FAILED) { // NOLINT(*cstyle-cast, *int-to-ptr)
+    logcerr::warn("unable to map {}", path.string());
+    return {};
+  }
+
+  // the pixels are read exactly once, while uploading or rescaling
+  madvise(data, size, MADV_SEQUENTIAL);
+  madvise(data, size, MADV_WILLNEED);
+
+  auto storage = std::make_shared<mapping>(data, size);
+
+  logcerr::verbose("mapped farbfeld file {} ({}x{})", path.string(), width, height);
+
+  return image{
+    .width   = static_cast<GLsizei>(width),
+    .height  = static_cast<GLsizei>(height),
+    .stride  = static_cast<size_t>(width) * bytes_per_pixel,
+    .format  = gl::texture::format::rgba16_be,
+    .pixels  = storage->bytes().subspan(header_size),
+    .storage = storage,
+
+    .original_size = {width, height}
+  };
+}
+
+
+
+
+void write_farbfeld(const std::filesystem::path& path, const image& img) {
+  if (img.format != gl::texture::format::rgba8) {
+    throw exception{"only rgba8 images can be written as farbfeld"};
+  }
+
+  std::ofstream output{path, std::ios::binary | std::ios::trunc};
+  if (!output) {
+    throw exception{logcerr::format("unable to open \"{}\" for writing", path.string())};
+  }
+
+  std::vector<char> buffer(header_size);
+
+  auto header = buffer.begin();
+  header = std::ranges::copy(farbfeld_magic, header).out;
+  write_big_endian(header, static_cast<uint32_t>(img.width),  4);
+  write_big_endian(header, static_cast<uint32_t>(img.height), 4);
+
+  output.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+
+  buffer.resize(static_cast<size_t>(img.width) * bytes_per_pixel);
+
+  for (GLsizei y = 0; y < img.height; ++y) {
+    auto it = buffer.begin();
+
+    // scale to the full 16 bit range, 0xff * 257 = 0xffff
+    for (auto channel: img.row(y).first(static_cast<size_t>(img.width) * 4)) {
+      write_big_endian(it, static_cast<uint32_t>(channel) * 257, 2);
+    }
+
+    output.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+  }
+
+  if (!output.flush()) {
+    throw exception{logcerr::format("unable to write \"{}\"", path.string())};
+  }
+}
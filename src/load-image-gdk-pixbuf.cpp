@@ -1,10 +1,13 @@
 #include "wallpablur/exception.hpp"
+#include "wallpablur/image.hpp"
 
 #include <algorithm>
 #include <filesystem>
 
 #include <gl/texture.hpp>
 
+#include <logcerr/log.hpp>
+
 #include <gdk-pixbuf/gdk-pixbuf.h>
 
 
@@ -20,6 +23,20 @@ namespace {
 
 
 
+  [[nodiscard]] vec2<uint32_t> file_size(const std::filesystem::path& path) {
+    int width {0};
+    int height{0};
+
+    if (gdk_pixbuf_get_file_info(path.string().c_str(), &width, &height) == nullptr
+        || width <= 0 || height <= 0) {
+      return {0, 0};
+    }
+
+    return {static_cast<uint32_t>(width), static_cast<uint32_t>(height)};
+  }
+
+
+
   [[nodiscard]] gl::texture::format pixel_format(GdkPixbuf* pixbuf) {
     if (gdk_pixbuf_get_has_alpha(pixbuf) == TRUE) {
       return gl::texture::format::rgba8;
@@ -30,11 +47,28 @@ namespace {
 
 
 
-gl::texture load_to_gl_texture(const std::filesystem::path& path) {
+image decode_image(
+  const std::filesystem::path&   path,
+  std::span<const decode_target> targets,
+  const image_sink&              sink
+) {
   GError* error_unsafe = nullptr;
 
-  std::unique_ptr<GdkPixbuf, pixbuf_destructor> pixbuf
-    {gdk_pixbuf_new_from_file(path.string().c_str(), &error_unsafe)};
+  auto original_size = file_size(path);
+  auto size          = decode_size(original_size, targets);
+
+  std::unique_ptr<GdkPixbuf, pixbuf_destructor> pixbuf;
+
+  if (size != original_size) {
+    // loaders like the jpeg one decode directly at the reduced size
+    logcerr::verbose("decoding {} at {:#} instead of {:#}", path.string(),
+        size, original_size);
+
+    pixbuf.reset(gdk_pixbuf_new_from_file_at_scale(path.string().c_str(),
+          static_cast<int>(size.x()), static_cast<int>(size.y()), TRUE, &error_unsafe));
+  } else {
+    pixbuf.reset(gdk_pixbuf_new_from_file(path.string().c_str(), &error_unsafe));
+  }
 
   std::unique_ptr<GError, gerror_destructor> error{error_unsafe};
 
@@ -48,6 +82,10 @@ gl::texture load_to_gl_texture(const std::filesystem::path& path) {
   int width  = gdk_pixbuf_get_width (pixbuf.get());
   int height = gdk_pixbuf_get_height(pixbuf.get());
 
+  if (original_size.x() == 0) {
+    original_size = {static_cast<uint32_t>(width), static_cast<uint32_t>(height)};
+  }
+
   if (gdk_pixbuf_get_bits_per_sample(pixbuf.get()) != 8) {
     throw exception{std::format("failed to use {}:\n"
       "only images with 8 bits per color channel are supported",
@@ -59,16 +97,71 @@ gl::texture load_to_gl_texture(const std::filesystem::path& path) {
     gdk_pixbuf_get_byte_length(pixbuf.get())
   };
 
-  std::vector<guint8> pixels_save_range;
+  auto stride = static_cast<size_t>(gdk_pixbuf_get_rowstride(pixbuf.get()));
+  auto format = pixel_format(pixbuf.get());
+
+  std::shared_ptr<const void> storage{std::move(pixbuf)};
 
-  if (auto size = static_cast<size_t>(height)
-                * static_cast<size_t>(gdk_pixbuf_get_rowstride(pixbuf.get()));
-      size != pixels.size()) {
+  if (sink.allocate) {
+    // the last row of a pixbuf may be shorter than the stride
+    auto memory = sink.allocate(width, height, stride, format);
+    std::ranges::copy(std::as_bytes(pixels), memory.begin());
 
-    pixels_save_range.resize(size);
-    std::ranges::copy(pixels, pixels_save_range.begin());
-    pixels = pixels_save_range;
+    if (sink.rows_ready) {
+      sink.rows_ready(0, height);
+    }
+
+    return image{
+      .width   = width,
+      .height  = height,
+      .stride  = stride,
+      .format  = format,
+      .pixels  = memory,
+      .storage = {},
+
+      .original_size = original_size
+    };
   }
 
-  return {width, height, std::as_bytes(pixels), pixel_format(pixbuf.get())};
+  if (auto size = static_cast<size_t>(height) * stride; size != pixels.size()) {
+    auto padded = std::make_shared<std::vector<guint8>>(size);
+    std::ranges::copy(pixels, padded->begin());
+    pixels  = *padded;
+    storage = std::move(padded);
+  }
+
+  return image{
+    .width   = width,
+    .height  = height,
+    .stride  = stride,
+    .format  = format,
+    .pixels  = std::as_bytes(pixels),
+    .storage = std::move(storage),
+
+    .original_size = original_size
+  };
+}
+
+
+
+
+void encode_png(const std::filesystem::path& path, const image& img) {
+  if (img.format != gl::texture::format::rgba8) {
+    throw exception{"only rgba8 images can be encoded as png"};
+  }
+
+  std::unique_ptr<GdkPixbuf, pixbuf_destructor> pixbuf{gdk_pixbuf_new_from_data(
+      reinterpret_cast<const guchar*>(img.pixels.data()), // NOLINT
+      GDK_COLORSPACE_RGB, TRUE, 8, img.width, img.height,
+      static_cast<int>(img.stride), nullptr, nullptr)};
+
+  GError* error_unsafe = nullptr;
+  gdk_pixbuf_save(pixbuf.get(), path.string().c_str(), "png", &error_unsafe, nullptr);
+
+  std::unique_ptr<GError, gerror_destructor> error{error_unsafe};
+
+  if (error) {
+    throw exception{std::format("failed to encode {} using gdk-pixbuf:\n{}",
+        path.string(), error->message)};
+  }
 }
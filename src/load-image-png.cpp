@@ -1,5 +1,7 @@
 #include "wallpablur/exception.hpp"
+#include "wallpablur/image.hpp"
 
+#include <algorithm>
 #include <filesystem>
 #include <memory>
 #include <stdexcept>
@@ -22,6 +24,10 @@ namespace {
     logcerr::warn("during decoding of png:\n{}", msg);
   }
 
+  [[noreturn]] void png_write_error(png_structp /*png*/, png_const_charp msg) {
+    throw exception{logcerr::format("unable to encode png: {}", msg), false, {}};
+  }
+
 
 
   struct png_guard {
@@ -57,16 +63,52 @@ namespace {
 
 
 
-  struct image {
+  struct png_write_guard {
+    png_structp ptr {nullptr};
+    png_infop   info{nullptr};
+
+    png_write_guard() :
+      ptr{png_create_write_struct(PNG_LIBPNG_VER_STRING, nullptr, nullptr, nullptr)}
+    {
+      if (ptr == nullptr) {
+        throw exception{"unable to create png write struct"};
+      }
+
+      png_set_error_fn(ptr, nullptr, png_write_error, png_warning);
+
+      info = png_create_info_struct(ptr);
+
+      if (info == nullptr) {
+        png_destroy_write_struct(&ptr, nullptr);
+        throw exception{"unable to create png info struct"};
+      }
+    }
+
+    png_write_guard(const png_write_guard&) = delete;
+    png_write_guard(png_write_guard&&)      = delete;
+    png_write_guard&operator= (const png_write_guard&) = delete;
+    png_write_guard&operator= (png_write_guard&&)      = delete;
+
+    ~png_write_guard() {
+      png_destroy_write_struct(&ptr, &info);
+    }
+  };
+
+
+
+  struct decoded_png {
     GLsizei width;
     GLsizei height;
 
     std::vector<png_byte> data;
+    std::span<png_byte>   pixels;
+
+    vec2<uint32_t>        original_size;
 
 
 
-    [[nodiscard]] std::span<png_byte> row(size_t i) {
-      return std::span{data}.subspan(i * width * 4);
+    [[nodiscard]] std::span<png_byte> row(size_t i) const {
+      return pixels.subspan(i * width * 4);
     }
   };
 
@@ -102,7 +144,63 @@ namespace {
 
 
 
-  [[nodiscard]] image load_png(const std::filesystem::path& path) {
+  [[nodiscard]] uint32_t reduction_factor(vec2<uint32_t> original, vec2<uint32_t> size) {
+    return std::max(1u, std::min(original.x() / size.x(), original.y() / size.y()));
+  }
+
+
+
+  // averages blocks of factor x factor pixels while streaming rows, so that the full
+  // sized image never has to be kept in memory
+  void read_reduced(
+      png_structp        png,
+      const decoded_png& img,
+      vec2<uint32_t>     original,
+      uint32_t           factor,
+      const image_sink&  sink
+  ) {
+    std::vector<png_byte> row(static_cast<size_t>(original.x()) * 4);
+    std::vector<uint32_t> sums(static_cast<size_t>(img.width) * 4);
+
+    for (uint32_t y = 0; y < original.y(); ++y) {
+      png_read_row(png, row.data(), nullptr);
+
+      for (size_t x = 0; x < original.x(); ++x) {
+        for (size_t c = 0; c < 4; ++c) {
+          sums[(x / factor) * 4 + c] += row[x * 4 + c];
+        }
+      }
+
+      if ((y + 1) % factor != 0 && y + 1 != original.y()) {
+        continue;
+      }
+
+      auto rows   = y % factor + 1;
+      auto target = img.row(y / factor);
+
+      for (size_t x = 0; x < static_cast<size_t>(img.width); ++x) {
+        auto count = rows * std::min<uint32_t>(factor, original.x() - x * factor);
+
+        for (size_t c = 0; c < 4; ++c) {
+          target[x * 4 + c] = static_cast<png_byte>((sums[x * 4 + c] + count / 2) / count);
+        }
+      }
+
+      if (sink.rows_ready) {
+        sink.rows_ready(static_cast<GLsizei>(y / factor), 1);
+      }
+
+      std::ranges::fill(sums, 0);
+    }
+  }
+
+
+
+  [[nodiscard]] decoded_png load_png(
+      const std::filesystem::path&   path,
+      std::span<const decode_target> targets,
+      const image_sink&              sink
+  ) {
     logcerr::verbose("loading png file \"{}\"", path.string());
     png_guard png;
 
@@ -111,25 +209,59 @@ namespace {
 
     png_read_info(png.ptr, png.info);
 
-    image img{
-      .width  = static_cast<GLsizei>(png_get_image_width(png.ptr, png.info)),
-      .height = static_cast<GLsizei>(png_get_image_height(png.ptr, png.info)),
-      .data   = std::vector<png_byte>(static_cast<size_t>(img.width) * img.height * 4)
+    vec2<uint32_t> original{
+      png_get_image_width(png.ptr, png.info),
+      png_get_image_height(png.ptr, png.info)
     };
 
     force_rgba8(png.ptr);
 
+    // has to be set up before the transformations are applied
+    int passes = png_set_interlace_handling(png.ptr);
+
     png_read_update_info(png.ptr, png.info);
 
-    if (static_cast<GLsizei>(png_get_rowbytes(png.ptr, png.info)) != img.width * 4) {
+    if (png_get_rowbytes(png.ptr, png.info) != static_cast<size_t>(original.x()) * 4) {
       throw exception{"error setting up png decoder: stride mismatch"};
     }
 
-    int passes = png_set_interlace_handling(png.ptr);
+    // interlaced images need the full sized buffer anyway
+    auto factor = passes == 1
+      ? reduction_factor(original, decode_size(original, targets)) : 1u;
+
+    decoded_png img{
+      .width  = static_cast<GLsizei>((original.x() + factor - 1) / factor),
+      .height = static_cast<GLsizei>((original.y() + factor - 1) / factor),
+      .data   = {},
+      .pixels = {},
+
+      .original_size = original
+    };
+
+    auto stride = static_cast<size_t>(img.width) * 4;
+
+    if (sink.allocate) {
+      auto memory = sink.allocate(img.width, img.height, stride, gl::texture::format::rgba8);
+      img.pixels = {reinterpret_cast<png_byte*>(memory.data()), memory.size()}; // NOLINT
+    } else {
+      img.data.resize(stride * img.height);
+      img.pixels = img.data;
+    }
+
+    if (factor > 1) {
+      logcerr::verbose("reducing png file by a factor of {}", factor);
+      read_reduced(png.ptr, img, original, factor, sink);
+      return img;
+    }
 
     for (int p = 0; p < passes; ++p) {
       for (GLsizei y = 0; y < img.height; ++y) {
         png_read_row(png.ptr, img.row(y).data(), nullptr);
+
+        // rows of interlaced images are only final after the last pass
+        if (sink.rows_ready && p + 1 == passes) {
+          sink.rows_ready(y, 1);
+        }
       }
     }
 
@@ -139,9 +271,49 @@ namespace {
 
 
 
-gl::texture load_to_gl_texture(const std::filesystem::path& path) {
-  auto image = load_png(path);
+image decode_image(
+  const std::filesystem::path&   path,
+  std::span<const decode_target> targets,
+  const image_sink&              sink
+) {
+  auto data = std::make_shared<decoded_png>(load_png(path, targets, sink));
+
+  return image{
+    .width   = data->width,
+    .height  = data->height,
+    .stride  = static_cast<size_t>(data->width) * 4,
+    .format  = gl::texture::format::rgba8,
+    .pixels  = std::as_bytes(data->pixels),
+    .storage = data,
+
+    .original_size = data->original_size
+  };
+}
+
+
+
+
+void encode_png(const std::filesystem::path& path, const image& img) {
+  if (img.format != gl::texture::format::rgba8) {
+    throw exception{"only rgba8 images can be encoded as png"};
+  }
+
+  file_ptr fp{fopen(path.string().c_str(), "wb")};
+  if (!fp) {
+    throw exception{logcerr::format("unable to open \"{}\" for writing", path.string())};
+  }
+
+  png_write_guard png;
+  png_init_io(png.ptr, fp.get());
+
+  png_set_IHDR(png.ptr, png.info, img.width, img.height, 8, PNG_COLOR_TYPE_RGBA,
+      PNG_INTERLACE_NONE, PNG_COMPRESSION_TYPE_DEFAULT, PNG_FILTER_TYPE_DEFAULT);
+
+  png_write_info(png.ptr, png.info);
+
+  for (GLsizei y = 0; y < img.height; ++y) {
+    png_write_row(png.ptr, reinterpret_cast<png_const_bytep>(img.row(y).data())); // NOLINT
+  }
 
-  return {image.width, image.height, std::as_bytes(std::span{image.data}),
-    gl::texture::format::rgba8};
+  png_write_end(png.ptr, nullptr);
 }
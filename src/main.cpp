@@ -1,6 +1,9 @@
 #include "wallpablur/application.hpp"
 #include "wallpablur/application-args.hpp"
+#include "wallpablur/config/config.hpp"
+#include "wallpablur/disk-cache.hpp"
 #include "wallpablur/exception.hpp"
+#include "wallpablur/render-headless.hpp"
 
 #include <cstdlib>
 
@@ -10,11 +13,31 @@
 
 
 
+namespace {
+  void setup_program_binary_cache() {
+    if (!config::global_config().disk_cache()) {
+      return;
+    }
+
+    if (auto directory = cache_directory()) {
+      gl::program::binary_cache_directory(*directory / "programs");
+    }
+  }
+}
+
+
+
 int main(int argc, char** argv) {
   std::span arg{argv, static_cast<size_t>(argc)};
 
   try {
     if (auto args = application_args::parse(arg)) {
+      setup_program_binary_cache();
+
+      if (args->render.target) {
+        return render_headless(*args);
+      }
+
       application app{*args};
       return app.run();
     }
@@ -91,6 +91,11 @@ void output::update(bool force) {
       }
     }
   }
+
+  if (painter_->update_textures(last_layout_)) {
+    last_layout_id_++;
+    surface_updated_.reset();
+  }
 }
 
 
@@ -125,9 +130,10 @@ void output::setup_surfaces() {
 
     wallpaper_surface_->set_render_cb([this]() {
       last_wallpaper_alpha_ = app().alpha();
-      painter_.value().render_wallpaper(last_layout_, last_wallpaper_alpha_,
+      auto damage = painter_.value().render_wallpaper(last_layout_, last_wallpaper_alpha_,
           last_layout_id_);
       surface_updated_[0] = true;
+      return damage;
     });
   }
 
@@ -152,17 +158,18 @@ void output::setup_surfaces() {
     });
 
 
-    clipping_surface_->set_render_cb([this]() {
+    clipping_surface_->set_render_cb([this]() -> std::optional<damage_region> {
       surface_updated_[1] = true;
       last_clipping_alpha_ = app().alpha();
 
       if (!clipping_surface_->visible()) {
         layout_painter::render_clear();
-        return;
+        return {};
       }
 
       painter_.value().render_clipping(last_layout_, last_clipping_alpha_,
           last_layout_id_);
+      return {};
     });
   }
 }
@@ -0,0 +1,82 @@
+#include "wallpablur/pixel-region.hpp"
+
+#include <algorithm>
+
+
+
+pixel_rect intersection(const pixel_rect& lhs, const pixel_rect& rhs) {
+  auto x0 = std::max(lhs.x, rhs.x);
+  auto y0 = std::max(lhs.y, rhs.y);
+  auto x1 = std::min(lhs.x + lhs.width,  rhs.x + rhs.width);
+  auto y1 = std::min(lhs.y + lhs.height, rhs.y + rhs.height);
+
+  return {.x = x0, .y = y0, .width = x1 - x0, .height = y1 - y0};
+}
+
+
+
+
+
+pixel_region::pixel_region(pixel_rect rect) {
+  if (!rect.empty()) {
+    rects_.emplace_back(rect);
+  }
+}
+
+
+
+void pixel_region::subtract(const pixel_rect& cut) {
+  std::vector<pixel_rect> output;
+  output.reserve(rects_.size());
+
+  for (const auto& rect: rects_) {
+    auto overlap = intersection(rect, cut);
+
+    if (overlap.empty()) {
+      output.emplace_back(rect);
+      continue;
+    }
+
+    // bands above and below the overlap span the whole width, the remaining pieces left
+    // and right of it only its height
+    pixel_rect above{
+      .x      = rect.x,
+      .y      = rect.y,
+      .width  = rect.width,
+      .height = overlap.y - rect.y
+    };
+
+    pixel_rect below{
+      .x      = rect.x,
+      .y      = overlap.y + overlap.height,
+      .width  = rect.width,
+      .height = rect.y + rect.height - overlap.y - overlap.height
+    };
+
+    pixel_rect left{
+      .x      = rect.x,
+      .y      = overlap.y,
+      .width  = overlap.x - rect.x,
+      .height = overlap.height
+    };
+
+    pixel_rect right{
+      .x      = overlap.x + overlap.width,
+      .y      = overlap.y,
+      .width  = rect.x + rect.width - overlap.x - overlap.width,
+      .height = overlap.height
+    };
+
+    for (const auto& piece: {above, below, left, right}) {
+      if (!piece.empty()) {
+        output.emplace_back(piece);
+      }
+    }
+  }
+
+  if (output.size() > max_rects) {
+    return;
+  }
+
+  rects_ = std::move(output);
+}
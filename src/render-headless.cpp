@@ -0,0 +1,220 @@
+#include "wallpablur/render-headless.hpp"
+#include "wallpablur/application-args.hpp"
+#include "wallpablur/config/config.hpp"
+#include "wallpablur/egl/context.hpp"
+#include "wallpablur/image.hpp"
+#include "wallpablur/layout-painter.hpp"
+#include "wallpablur/texture-provider.hpp"
+#include "wallpablur/wm/i3ipc.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <tuple>
+#include <vector>
+
+#include <logcerr/log.hpp>
+
+
+
+namespace {
+  class stage_timer {
+    public:
+      using clock = std::chrono::steady_clock;
+
+      void finish(std::string_view stage) {
+        auto now = clock::now();
+        logcerr::log("{:<10} {:>9.2f} ms", stage, milliseconds(now - last_));
+        last_ = now;
+      }
+
+      void total() const {
+        logcerr::log("{:<10} {:>9.2f} ms", "total", milliseconds(clock::now() - start_));
+      }
+
+
+
+    private:
+      clock::time_point start_{clock::now()};
+      clock::time_point last_ {start_};
+
+      [[nodiscard]] static double milliseconds(clock::duration duration) {
+        return std::chrono::duration<double, std::milli>(duration).count();
+      }
+  };
+
+
+
+  [[nodiscard]] std::pair<std::string, workspace> load_layout(const render_args& args) {
+    if (!args.layout) {
+      return {args.output.value_or("HEADLESS-1"), {}};
+    }
+
+    std::ifstream input{*args.layout};
+    if (!input) {
+      throw exception{logcerr::format("unable to read layout at \"{}\"",
+          args.layout->string())};
+    }
+
+    auto layouts = wm::parse_layouts(std::string{std::istreambuf_iterator<char>{input},
+        std::istreambuf_iterator<char>{}});
+
+    for (auto& [name, layout]: layouts) {
+      if (!args.output || name == *args.output) {
+        return {std::move(name), std::move(layout)};
+      }
+    }
+
+    if (args.output) {
+      throw exception{logcerr::format("output {} not found in layout", *args.output)};
+    }
+
+    throw exception{"layout does not contain any active output"};
+  }
+
+
+
+  [[nodiscard]] wayland::geometry geometry_for(const render_args& args, const workspace& ws) {
+    wayland::geometry geometry;
+    geometry.scale(args.scale);
+
+    if (args.size) {
+      geometry.physical_size(*args.size);
+    } else if (ws.size().x() > 0 && ws.size().y() > 0) {
+      geometry.physical_size(vec_cast<uint32_t>(
+        floor(ws.size() * args.scale + vec2<float>{0.5f, 0.5f})));
+    } else {
+      geometry.physical_size({1920, 1080});
+    }
+
+    return geometry;
+  }
+
+
+
+  void add_fixed_panels(workspace& ws, const config::output& config,
+      const wayland::geometry& geometry) {
+    auto layout = ws;
+
+    for (const auto& panel: config.fixed_panels) {
+      if (panel.condition.evaluate(layout)) {
+        ws.emplace_surface(panel.to_rect(geometry.logical_size()), panel.app_id,
+            panel.mask, panel.radius);
+      }
+    }
+  }
+
+
+
+  [[nodiscard]] image read_framebuffer(const wayland::geometry& geometry) {
+    auto width  = static_cast<GLsizei>(geometry.physical_size().x());
+    auto height = static_cast<GLsizei>(geometry.physical_size().y());
+    auto stride = static_cast<size_t>(width) * 4;
+
+    auto pixels = std::make_shared<std::vector<std::byte>>(stride * height);
+
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, pixels->data());
+
+    // the framebuffer is bottom-up and premultiplied
+    for (GLsizei y = 0; y < height / 2; ++y) {
+      std::swap_ranges(
+          pixels->begin() + static_cast<ptrdiff_t>(y * stride),
+          pixels->begin() + static_cast<ptrdiff_t>((y + 1) * stride),
+          pixels->begin() + static_cast<ptrdiff_t>((height - 1 - y) * stride));
+    }
+
+    for (size_t i = 0; i < pixels->size(); i += 4) {
+      auto alpha = static_cast<unsigned int>((*pixels)[i + 3]);
+      if (alpha == 0 || alpha == 255) {
+        continue;
+      }
+
+      for (size_t c = 0; c < 3; ++c) {
+        auto value = static_cast<unsigned int>((*pixels)[i + c]);
+        (*pixels)[i + c] = static_cast<std::byte>(std::min(255u,
+              (value * 255 + alpha / 2) / alpha));
+      }
+    }
+
+    return image{
+      .width   = width,
+      .height  = height,
+      .stride  = stride,
+      .format  = gl::texture::format::rgba8,
+      .pixels  = *pixels,
+      .storage = pixels,
+
+      .original_size = geometry.physical_size()
+    };
+  }
+}
+
+
+
+
+
+int render_headless(const application_args& args) {
+  auto& cfg = config::global_config();
+  cfg.watch_images(false);
+
+  stage_timer timer;
+
+  auto [name, ws] = load_layout(args.render);
+  auto geometry   = geometry_for(args.render, ws);
+  auto config     = cfg.output_config_for(name);
+
+  add_fixed_panels(ws, config, geometry);
+
+  logcerr::verbose("rendering {} at {:#}@{} with {} surface(s)", name,
+      geometry.physical_size(), geometry.scale(), ws.surfaces().size());
+
+  timer.finish("layout");
+
+
+
+  auto context = std::make_shared<egl::context>(egl::context::headless(
+        static_cast<EGLint>(geometry.physical_size().x()),
+        static_cast<EGLint>(geometry.physical_size().y())));
+
+  auto provider = std::make_shared<texture_provider>(context);
+
+  timer.finish("context");
+
+
+
+  layout_painter painter{std::move(config), provider};
+  painter.set_wallpaper_context(context);
+
+  timer.finish("shaders");
+
+
+
+  painter.update_geometry(geometry);
+  painter.wait_for_textures(ws);
+  std::ignore = painter.update_textures(ws);
+
+  timer.finish("textures");
+
+
+
+  std::ignore = painter.update_rounded_corners(ws, 1);
+  painter.render_wallpaper(ws, cfg.opacity(), 1);
+  glFinish();
+
+  timer.finish("render");
+
+
+
+  auto output = read_framebuffer(geometry);
+
+  timer.finish("readback");
+
+  save_image(*args.render.target, output);
+
+  timer.finish("encode");
+  timer.total();
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,71 @@
+#include "wallpablur/render-target-pool.hpp"
+
+#include <algorithm>
+
+
+
+render_target::render_target(gl::texture_size s, gl::texture::format fmt) :
+  render_target{gl::texture{s, fmt}, s, fmt}
+{}
+
+
+
+render_target::render_target(
+  gl::texture&&       tex,
+  gl::texture_size    s,
+  gl::texture::format fmt
+) :
+  size       {s},
+  format     {fmt},
+  texture    {std::move(tex)},
+  framebuffer{texture}
+{}
+
+
+
+
+
+namespace {
+  [[nodiscard]] bool matches(
+      const render_target& target,
+      gl::texture_size     size,
+      gl::texture::format  format
+  ) {
+    return target.size.width == size.width && target.size.height == size.height
+      && target.format == format;
+  }
+}
+
+
+
+render_target render_target_pool::acquire(gl::texture_size size, gl::texture::format fmt) {
+  auto it = std::ranges::find_if(targets_, [size, fmt](const auto& target) {
+      return matches(target, size, fmt); });
+
+  if (it == targets_.end()) {
+    return render_target{size, fmt};
+  }
+
+  auto target = std::move(*it);
+  targets_.erase(it);
+
+  return target;
+}
+
+
+
+void render_target_pool::recycle(render_target&& target) {
+  auto count = std::ranges::count_if(targets_, [&target](const auto& t) {
+      return matches(t, target.size, target.format); });
+
+  if (static_cast<size_t>(count) < max_targets_per_size) {
+    targets_.emplace_back(std::move(target));
+  }
+}
+
+
+
+void render_target_pool::recycle(gl::texture&& texture, gl::texture::format fmt) {
+  auto size = texture.size();
+  recycle(render_target{std::move(texture), size, fmt});
+}
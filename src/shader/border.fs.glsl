@@ -0,0 +1,76 @@
+#version 450
+
+// one of FALLOFF_STEP, FALLOFF_LINEAR and FALLOFF_SINUSOIDAL is defined when the
+// program is created
+
+in vec2 localCoord;
+flat in vec2  centerSize;
+flat in float reach;
+flat in float thickness;
+flat in uint  sides;
+
+out vec4 fragColor;
+
+
+
+layout (location = 10) uniform vec4  color_rgba;
+
+#ifndef FALLOFF_STEP
+layout (location = 20) uniform float exponent;
+#endif
+
+
+
+// distance to the sides of the center which carry a border, negative inside of a center
+// with borders on all sides
+float border_distance() {
+  vec2 p = localCoord;
+  vec2 c = centerSize;
+
+  if (sides == 15u) {
+    vec2 q = abs(p) - c;
+    return length(max(q, 0.f)) + min(max(q.x, q.y), 0.f);
+  }
+
+  vec2  h = max(abs(p) - c, 0.f);
+  float d = reach + thickness;
+
+  if ((sides & 1u) != 0u) { d = min(d, length(vec2(h.x, p.y - c.y))); }
+  if ((sides & 2u) != 0u) { d = min(d, length(vec2(p.x - c.x, h.y))); }
+  if ((sides & 4u) != 0u) { d = min(d, length(vec2(h.x, p.y + c.y))); }
+  if ((sides & 8u) != 0u) { d = min(d, length(vec2(p.x + c.x, h.y))); }
+
+  return d;
+}
+
+
+
+// 1 up to the corner radius, 0 at `thickness` beyond it; without a falloff the edge is
+// only antialiased
+float falloff() {
+#ifdef FALLOFF_STEP
+  return clamp((reach - border_distance()) / fwidth(localCoord.x) + 0.5f, 0.f, 1.f);
+#else
+  return clamp((reach - border_distance()) / max(thickness, fwidth(localCoord.x)),
+      0.f, 1.f);
+#endif
+}
+
+
+
+void main() {
+  float f = falloff();
+
+  if (f <= 0.f) {
+    discard;
+  }
+
+#if defined(FALLOFF_STEP)
+  fragColor = color_rgba * f;
+#elif defined(FALLOFF_LINEAR)
+  fragColor = color_rgba * pow(f, exponent);
+#else
+  float v = 0.5f * cos((1 - f) * 3.141592653) + 0.5f;
+  fragColor = color_rgba * pow(v, exponent);
+#endif
+}
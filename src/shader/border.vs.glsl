@@ -2,13 +2,52 @@
 
 layout (location = 0) in vec4 position;
 
-out float falloff;
+// per instance: position and size in logical pixels, the part of it covered by the mesh
+// and corner radius, thickness and bit mask of the sides with a border
+layout (location = 1) in vec4 rect;
+layout (location = 2) in vec4 clip;
+layout (location = 3) in vec4 parameters;
 
-layout (location = 0) uniform mat4 transform;
+layout (location = 0) uniform vec2 logical_size;
+
+out vec2 localCoord;
+flat out vec2  centerSize;
+flat out float reach;
+flat out float thickness;
+flat out uint  sides;
+
+
+
+// logical position of the vertex with y pointing down
+vec2 logical_position() {
+  return clip.xy + 0.5f * (position.xy * vec2(1.f, -1.f) + vec2(1.f)) * clip.zw;
+}
+
+
+
+vec4 transform(vec2 logical) {
+  return vec4((2.f * logical / logical_size - vec2(1.f)) * vec2(1.f, -1.f),
+      position.z, position.w);
+}
+
+
+
+// relative to the center of `rect` with y pointing up
+vec2 local_position(vec2 logical) {
+  return (logical - rect.xy - 0.5f * rect.zw) * vec2(1.f, -1.f);
+}
 
 
 
 void main() {
-  gl_Position = transform * position;
-  falloff     = position.z;
+  vec2 logical = logical_position();
+
+  gl_Position = transform(logical);
+  localCoord  = local_position(logical);
+
+  // the instance covers the tile inset by the radius, extended by radius + thickness
+  thickness   = parameters.y;
+  reach       = parameters.x + parameters.y;
+  centerSize  = max(0.5f * rect.zw - reach, vec2(0.f));
+  sides       = uint(parameters.z);
 }
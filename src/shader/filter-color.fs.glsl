@@ -0,0 +1,15 @@
+#version 450
+
+in vec2 texCoord;
+
+out vec4 fragColor;
+
+uniform sampler2D textureSampler;
+uniform mat4      colorMatrix;
+uniform vec4      colorOffset;
+
+
+
+void main() {
+  fragColor = colorMatrix * texture(textureSampler, texCoord) + colorOffset;
+}
@@ -0,0 +1,23 @@
+#version 450
+
+in vec2 texCoord;
+
+out vec4 fragColor;
+
+uniform sampler2D textureSampler;
+uniform float     dithering;
+
+
+
+vec4 noise(vec2 position) {
+  return (fract(dot(position, vec2(2718.28, 3141.592))
+    * vec4(420.420f, 47.47f, 69.69f, 42.42f)) - 0.5f) * dithering;
+}
+
+
+
+void main() {
+  // with linear filtering, a single sample averages the 2x2 (or 2x1) block below
+  fragColor = noise(gl_FragCoord.xy / vec2(textureSize(textureSampler, 0)))
+    + texture(textureSampler, texCoord);
+}
@@ -0,0 +1,43 @@
+#version 450
+
+in vec2 texCoord;
+
+out vec4 fragColor;
+
+uniform sampler2D textureSampler;
+uniform int       taps;
+uniform float     weights[128];
+uniform float     offsets[128];
+uniform vec2      direction;
+uniform float     dithering;
+
+#ifdef COLOR_TRANSFORM
+uniform mat4      colorMatrix;
+uniform vec4      colorOffset;
+#endif
+
+
+
+vec4 noise(vec2 position) {
+  return (fract(dot(position, vec2(2718.28, 3141.592))
+    * vec4(420.420f, 47.47f, 69.69f, 42.42f)) - 0.5f) * dithering;
+}
+
+
+
+void main() {
+  vec4 sum = texture(textureSampler, texCoord) * weights[0];
+
+  for (int i = 1; i < taps; ++i) {
+    vec2 offset = offsets[i] * direction;
+
+    sum += (texture(textureSampler, texCoord + offset)
+            + texture(textureSampler, texCoord - offset)) * weights[i];
+  }
+
+#ifdef COLOR_TRANSFORM
+  sum = colorMatrix * sum + colorOffset;
+#endif
+
+  fragColor = noise(gl_FragCoord.xy / vec2(textureSize(textureSampler, 0))) + sum;
+}
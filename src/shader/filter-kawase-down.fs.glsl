@@ -0,0 +1,21 @@
+#version 450
+
+in vec2 texCoord;
+
+out vec4 fragColor;
+
+uniform sampler2D textureSampler;
+uniform vec2      offset;
+
+
+
+void main() {
+  vec4 sum = texture(textureSampler, texCoord) * 4.f;
+
+  sum += texture(textureSampler, texCoord - offset);
+  sum += texture(textureSampler, texCoord + offset);
+  sum += texture(textureSampler, texCoord + vec2(offset.x, -offset.y));
+  sum += texture(textureSampler, texCoord - vec2(offset.x, -offset.y));
+
+  fragColor = sum / 8.f;
+}
@@ -0,0 +1,44 @@
+#version 450
+
+in vec2 texCoord;
+
+out vec4 fragColor;
+
+uniform sampler2D textureSampler;
+uniform vec2      offset;
+uniform vec2      outputSize;
+uniform float     dithering;
+
+#ifdef COLOR_TRANSFORM
+uniform mat4      colorMatrix;
+uniform vec4      colorOffset;
+#endif
+
+
+
+vec4 noise(vec2 position) {
+  return (fract(dot(position, vec2(2718.28, 3141.592))
+    * vec4(420.420f, 47.47f, 69.69f, 42.42f)) - 0.5f) * dithering;
+}
+
+
+
+void main() {
+  vec4 sum = texture(textureSampler, texCoord + vec2(-2.f * offset.x, 0.f));
+  sum += texture(textureSampler, texCoord + vec2( 2.f * offset.x, 0.f));
+  sum += texture(textureSampler, texCoord + vec2(0.f, -2.f * offset.y));
+  sum += texture(textureSampler, texCoord + vec2(0.f,  2.f * offset.y));
+
+  sum += texture(textureSampler, texCoord + vec2(-offset.x,  offset.y)) * 2.f;
+  sum += texture(textureSampler, texCoord + vec2( offset.x,  offset.y)) * 2.f;
+  sum += texture(textureSampler, texCoord + vec2( offset.x, -offset.y)) * 2.f;
+  sum += texture(textureSampler, texCoord + vec2(-offset.x, -offset.y)) * 2.f;
+
+  sum /= 12.f;
+
+#ifdef COLOR_TRANSFORM
+  sum = colorMatrix * sum + colorOffset;
+#endif
+
+  fragColor = noise(gl_FragCoord.xy / outputSize) + sum;
+}
@@ -9,6 +9,11 @@ uniform int       samples;
 uniform vec2      direction;
 uniform float     dithering;
 
+#ifdef COLOR_TRANSFORM
+uniform mat4      colorMatrix;
+uniform vec4      colorOffset;
+#endif
+
 
 
 vec4 noise(vec2 position) {
@@ -27,6 +32,9 @@ void main() {
 
   average /= 2 * samples + 1;
 
+#ifdef COLOR_TRANSFORM
+  average = colorMatrix * average + colorOffset;
+#endif
 
   fragColor = noise(texCoord) + average;
 }
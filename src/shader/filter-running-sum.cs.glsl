@@ -0,0 +1,82 @@
+#version 450
+
+// x: lines, y: segments of a line
+layout (local_size_x = 64) in;
+
+layout (binding = 0)        uniform sampler2D textureSampler;
+layout (binding = 0, rgba8) uniform writeonly image2D outputImage;
+
+uniform int   samples;
+uniform int   segment;
+uniform ivec2 direction;
+uniform float dithering;
+
+#ifdef COLOR_TRANSFORM
+uniform mat4  colorMatrix;
+uniform vec4  colorOffset;
+#endif
+
+
+
+vec4 noise(vec2 position) {
+  return (fract(dot(position, vec2(2718.28, 3141.592))
+    * vec4(420.420f, 47.47f, 69.69f, 42.42f)) - 0.5f) * dithering;
+}
+
+
+
+int mirror(int index, int size) {
+  int period = 2 * size;
+  int i      = (index < 0 ? -index - 1 : index) % period;
+
+  return i < size ? i : period - 1 - i;
+}
+
+
+
+uvec4 fetch(int index, int length, ivec2 origin) {
+  vec4 value = texelFetch(textureSampler, origin + mirror(index, length) * direction, 0);
+  return uvec4(round(value * 255.f));
+}
+
+
+
+void main() {
+  ivec2 size   = textureSize(textureSampler, 0);
+  ivec2 across = ivec2(1, 1) - direction;
+
+  int line   = int(gl_GlobalInvocationID.x);
+  int length = size.x * direction.x + size.y * direction.y;
+
+  int first = int(gl_GlobalInvocationID.y) * segment;
+  int last  = min(first + segment, length);
+
+  if (line >= size.x * across.x + size.y * across.y || first >= length) {
+    return;
+  }
+
+  ivec2 origin = line * across;
+
+  // every segment sets up its own window, so that long lines do not run serially
+  uvec4 sum = uvec4(0);
+  for (int i = first - samples; i <= first + samples; ++i) {
+    sum += fetch(i, length, origin);
+  }
+
+
+  for (int p = first; p < last; ++p) {
+    ivec2 position = origin + p * direction;
+    vec2  fragCoord = vec2(position) + 0.5f;
+
+    vec4 average = vec4(sum) * (1.f / (255.f * float(2 * samples + 1)));
+
+#ifdef COLOR_TRANSFORM
+    average = colorMatrix * average + colorOffset;
+#endif
+
+    imageStore(outputImage, position, noise(fragCoord / vec2(size)) + average);
+
+    sum += fetch(p + samples + 1, length, origin);
+    sum -= fetch(p - samples,     length, origin);
+  }
+}
@@ -6,8 +6,20 @@ out vec4 fragColor;
 
 uniform sampler2D textureSampler;
 
+#ifdef COLOR_TRANSFORM
+uniform vec4      background;
+uniform mat4      colorMatrix;
+uniform vec4      colorOffset;
+#endif
+
 
 
 void main() {
+#ifdef COLOR_TRANSFORM
+  // blending has to happen before the color transform
+  vec4 color = texture(textureSampler, texCoord);
+  fragColor = colorMatrix * (color + (1.f - color.a) * background) + colorOffset;
+#else
   fragColor = texture(textureSampler, texCoord);
+#endif
 }
@@ -0,0 +1,23 @@
+// inserted into the fragment shaders of rounded rectangles after the #version line
+
+in vec2 localCoord;
+flat in vec2 halfSize;
+flat in float radius;
+
+
+
+// signed distance to the edge of the rounded rectangle, negative inside
+float rounded_rect_distance() {
+  vec2 q = abs(localCoord) - halfSize + radius;
+  return length(max(q, 0.f)) + min(max(q.x, q.y), 0.f) - radius;
+}
+
+
+
+// antialiased coverage of the rounded rectangle
+float coverage() {
+  float d = rounded_rect_distance();
+  float w = 0.5f * fwidth(d);
+
+  return 1.f - smoothstep(-w, w, d);
+}
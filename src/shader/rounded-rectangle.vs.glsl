@@ -0,0 +1,49 @@
+#version 450 core
+
+layout (location = 0) in vec4 position;
+
+// per instance: position and size in logical pixels, the part of it covered by the mesh
+// and the corner radius
+layout (location = 1) in vec4 rect;
+layout (location = 2) in vec4 clip;
+layout (location = 3) in vec4 parameters;
+
+layout (location = 0) uniform vec2 logical_size;
+
+out vec2 texCoord;
+out vec2 localCoord;
+flat out vec2 halfSize;
+flat out float radius;
+
+
+
+// logical position of the vertex with y pointing down
+vec2 logical_position() {
+  return clip.xy + 0.5f * (position.xy * vec2(1.f, -1.f) + vec2(1.f)) * clip.zw;
+}
+
+
+
+vec4 transform(vec2 logical) {
+  return vec4((2.f * logical / logical_size - vec2(1.f)) * vec2(1.f, -1.f),
+      position.z, position.w);
+}
+
+
+
+// relative to the center of `rect` with y pointing up
+vec2 local_position(vec2 logical) {
+  return (logical - rect.xy - 0.5f * rect.zw) * vec2(1.f, -1.f);
+}
+
+
+
+void main() {
+  vec2 logical = logical_position();
+
+  gl_Position = transform(logical);
+  texCoord    = (gl_Position.xy + vec2(1.f, 1.f)) / 2.f;
+  localCoord  = local_position(logical);
+  halfSize    = 0.5f * rect.zw;
+  radius      = min(parameters.x, min(halfSize.x, halfSize.y));
+}
@@ -2,13 +2,27 @@
 
 layout (location = 0) in vec4 position;
 
-layout (location = 0) uniform mat4 transform;
+// per instance: position and size in logical pixels of the area covered by the mesh
+layout (location = 2) in vec4 clip;
 
-out vec2 genCoord;
+layout (location = 0) uniform vec2 logical_size;
+
+
+
+// logical position of the vertex with y pointing down
+vec2 logical_position() {
+  return clip.xy + 0.5f * (position.xy * vec2(1.f, -1.f) + vec2(1.f)) * clip.zw;
+}
+
+
+
+vec4 transform(vec2 logical) {
+  return vec4((2.f * logical / logical_size - vec2(1.f)) * vec2(1.f, -1.f),
+      position.z, position.w);
+}
 
 
 
 void main() {
-  gl_Position = transform * position;
-  genCoord    = 0.5f * (position.xy + vec2(1.f, 1.f));
+  gl_Position = transform(logical_position());
 }
@@ -0,0 +1,191 @@
+#include "wallpablur/source-cache.hpp"
+
+#include <algorithm>
+#include <utility>
+
+#include <logcerr/log.hpp>
+
+
+
+namespace {
+  [[nodiscard]] std::filesystem::file_time_type modification_time(
+      const std::filesystem::path& path
+  ) {
+    std::error_code ec;
+    auto mtime = std::filesystem::last_write_time(path, ec);
+    if (ec) {
+      return {};
+    }
+    return mtime;
+  }
+
+
+
+  [[nodiscard]] bool covers(
+      vec2<uint32_t>       original_size,
+      vec2<uint32_t>       size,
+      const decode_target& target
+  ) {
+    auto needed = decode_size(original_size, std::span{&target, 1});
+    return needed.x() <= size.x() && needed.y() <= size.y();
+  }
+}
+
+
+
+source_cache::source_cache(size_t budget) :
+  budget_{budget}
+{}
+
+
+
+source_cache::entry& source_cache::lookup(
+  const std::filesystem::path& path,
+  const decode_target&         target
+) {
+  auto  mtime = modification_time(path);
+  auto& entry = entries_.find_or_create(path);
+
+  if (std::ranges::find(entry.targets, target) == entry.targets.end()) {
+    entry.targets.emplace_back(target);
+  }
+
+  if (!entry.decoded && !entry.texture) {
+    return entry;
+  }
+
+  if (entry.mtime == mtime && covers(entry.original_size, entry.size, target)) {
+    logcerr::verbose("reusing decoded image {}", path.string());
+    return entry;
+  }
+
+  entry.decoded.reset();
+  entry.texture.reset();
+  entry.bytes = 0;
+
+  return entry;
+}
+
+
+
+image source_cache::load(entry& entry, const std::filesystem::path& path) {
+  entry.mtime = modification_time(path);
+
+  auto img = load_image(path, entry.targets);
+
+  entry.original_size = img.original_size;
+  entry.size          = {static_cast<uint32_t>(img.width), static_cast<uint32_t>(img.height)};
+  entry.bytes         = img.pixels.size();
+
+  return img;
+}
+
+
+
+
+
+const image& source_cache::decoded(
+  const std::filesystem::path& path,
+  const decode_target&         target
+) {
+  auto& entry = lookup(path, target);
+
+  if (!entry.decoded) {
+    entry.decoded = load(entry, path);
+  }
+
+  return *entry.decoded;
+}
+
+
+
+const gl::texture& source_cache::texture(
+  const std::filesystem::path& path,
+  const decode_target&         target
+) {
+  auto& entry = lookup(path, target);
+
+  if (entry.texture) {
+    return *entry.texture;
+  }
+
+  if (entry.decoded) {
+    entry.texture = to_texture(*entry.decoded,
+        mipmap_levels(entry.size, entry.targets));
+    entry.decoded.reset();
+  } else {
+    entry.mtime = modification_time(path);
+
+    auto uploaded = load_texture(path, entry.targets, upload_buffer_);
+
+    entry.original_size = uploaded.original_size;
+    entry.size          = uploaded.size;
+    entry.texture       = std::move(uploaded.texture);
+  }
+
+  // roughly, mipmaps and wider formats are not accounted for
+  entry.bytes = static_cast<size_t>(entry.size.x()) * entry.size.y() * 4;
+
+  return *entry.texture;
+}
+
+
+
+
+
+void source_cache::plan(std::span<const source_request> requests) {
+  if (requests.empty()) {
+    upload_buffer_.reset();
+  }
+
+  auto now = ++tick_;
+
+  for (const auto& request: requests) {
+    auto& entry = entries_.find_or_create(request.path);
+
+    if (entry.last_used != now) {
+      entry.last_used = now;
+      entry.targets.clear();
+    }
+
+    if (std::ranges::find(entry.targets, request.target) == entry.targets.end()) {
+      entry.targets.emplace_back(request.target);
+    }
+  }
+
+  evict_unplanned();
+}
+
+
+
+void source_cache::evict_unplanned() {
+  // outputs which are configured later may still need the other sources
+  size_t usage{0};
+  for (size_t i = 0; i < entries_.size(); ++i) {
+    if (entries_.value(i).last_used != tick_) {
+      usage += entries_.value(i).bytes;
+    }
+  }
+
+  while (usage > budget_) {
+    std::optional<size_t> lru;
+
+    for (size_t i = 0; i < entries_.size(); ++i) {
+      const auto& entry = entries_.value(i);
+
+      if (entry.last_used != tick_ && entry.bytes > 0
+          && (!lru || entry.last_used < entries_.value(*lru).last_used)) {
+        lru = i;
+      }
+    }
+
+    if (!lru) {
+      break;
+    }
+
+    logcerr::verbose("dropping decoded image {}", entries_.key(*lru).string());
+
+    usage -= entries_.value(*lru).bytes;
+    entries_.erase(*lru);
+  }
+}
@@ -1,13 +1,23 @@
 #include "wallpablur/texture-generator.hpp"
 
+#include "wallpablur/config/config.hpp"
 #include "wallpablur/config/filter.hpp"
+#include "wallpablur/cpu-filter.hpp"
 #include "wallpablur/exception.hpp"
 #include "wallpablur/gl/utils.hpp"
+#include "wallpablur/image.hpp"
 #include "shader/shader.hpp"
 
 #include <algorithm>
 #include <array>
+#include <bit>
+#include <cmath>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <tuple>
 #include <utility>
+#include <vector>
 
 #include <logcerr/log.hpp>
 
@@ -15,10 +25,6 @@
 
 
 
-[[nodiscard]] gl::texture load_to_gl_texture(const std::filesystem::path&);
-
-
-
 namespace {
   [[nodiscard]] std::shared_ptr<egl::context> make_current(
       std::shared_ptr<egl::context> context
@@ -26,6 +32,12 @@ namespace {
     context->make_current();
     return context;
   }
+
+
+
+  [[nodiscard]] size_t source_cache_budget() {
+    return static_cast<size_t>(config::global_config().source_cache_size_mb()) << 20u;
+  }
 }
 
 
@@ -33,7 +45,13 @@ namespace {
 texture_generator::texture_generator(std::shared_ptr<egl::context> context) :
   context_     {make_current(std::move(context))},
   quad_        {gl::create_quad()},
-  draw_texture_{resources::rescale_texture_vs(), resources::rescale_texture_fs()}
+  draw_texture_{resources::rescale_texture_vs(), resources::rescale_texture_fs()},
+
+  line_sampler_    {GL_MIRRORED_REPEAT, GL_NEAREST},
+  blur_sampler_    {GL_MIRRORED_REPEAT, GL_LINEAR},
+  resample_sampler_{GL_CLAMP_TO_EDGE,   GL_LINEAR},
+
+  source_cache_{source_cache_budget()}
 {}
 
 
@@ -44,12 +62,23 @@ namespace {
   void setup_context(const egl::context& context) {
     context.make_current();
 
-    glEnable(GL_BLEND);
+    // filter passes overwrite every pixel of a (possibly reused) render target,
+    // only the base texture is blended on top of the solid color
+    glDisable(GL_BLEND);
     glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
   }
 
 
 
+  template<typename Pass>
+  void ping_pong(render_target& current, render_target_pool& pool, const Pass& pass) {
+    auto next = pass(current.texture);
+    pool.recycle(std::move(current));
+    current = std::move(next);
+  }
+
+
+
   [[nodiscard]] std::array<float, 4> scale_matrix(vec2<float> scale) {
     return {
       scale.x(), 0.f,
@@ -76,43 +105,210 @@ namespace {
 
 
 
-  [[nodiscard]] std::array<float, 4> scale_matrix(
-    config::scale_mode       scale_mode,
-    const wayland::geometry& geometry,
+}
+
+
+
+
+
+struct color_transform {
+  // column-major, as expected by glUniformMatrix4fv
+  std::array<float, 16> matrix{
+    1.f, 0.f, 0.f, 0.f,
+    0.f, 1.f, 0.f, 0.f,
+    0.f, 0.f, 1.f, 0.f,
+    0.f, 0.f, 0.f, 1.f
+  };
+  std::array<float, 4>  offset{0.f, 0.f, 0.f, 0.f};
+
+  bool operator==(const color_transform&) const = default;
+};
+
+
+
+namespace {
+  [[nodiscard]] bool is_identity(const color_transform& transform) {
+    return transform == color_transform{};
+  }
+
+
+
+  [[nodiscard]] std::optional<color_transform> color_transform_of(
+      const config::filter& filter
+  ) {
+    if (std::holds_alternative<config::invert_filter>(filter)) {
+      return color_transform{
+        .matrix = {
+          -1.f,  0.f,  0.f, 0.f,
+           0.f, -1.f,  0.f, 0.f,
+           0.f,  0.f, -1.f, 0.f,
+           0.f,  0.f,  0.f, 1.f
+        },
+        .offset = {1.f, 1.f, 1.f, 0.f}
+      };
+    }
+
+    return {};
+  }
+
+
+
+  [[nodiscard]] color_transform then(
+      const color_transform& first,
+      const color_transform& second
+  ) {
+    color_transform output;
+
+    for (size_t row = 0; row < 4; ++row) {
+      output.offset[row] = second.offset[row];
+
+      for (size_t column = 0; column < 4; ++column) {
+        float sum{0.f};
+        for (size_t k = 0; k < 4; ++k) {
+          sum += second.matrix[k * 4 + row] * first.matrix[column * 4 + k];
+        }
+        output.matrix[column * 4 + row] = sum;
+
+        output.offset[row] += second.matrix[column * 4 + row] * first.offset[column];
+      }
+    }
+
+    return output;
+  }
+
+
+
+  struct filter_pass {
+    // a standalone color transform if empty
+    std::optional<config::filter> filter;
+    color_transform               output;
+  };
+
+  struct filter_program {
+    // applied by the rescale or upsample pass
+    color_transform          input;
+    std::vector<filter_pass> passes;
+  };
+
+
 
-    vec2<float>              size
+  // per-pixel filters do not need a pass of their own, they are applied to the result
+  // of the previous pass instead
+  [[nodiscard]] filter_program compile(
+      std::span<const config::filter> filters,
+      bool                            leading_pass
   ) {
-    auto physical_size = vec_cast<float>(geometry.physical_size());
-    auto s = div(size, physical_size);
+    filter_program program;
+
+    for (const auto& filter: filters) {
+      auto transform = color_transform_of(filter);
 
-    switch (scale_mode) {
-      case config::scale_mode::zoom:
-        return scale_matrix(div(physical_size * std::min(s.x(), s.y()), size));
+      if (!transform) {
+        program.passes.push_back({.filter = filter, .output = {}});
 
-      case config::scale_mode::fit:
-        return scale_matrix(div(physical_size * std::max(s.x(), s.y()), size));
+      } else if (!program.passes.empty()) {
+        program.passes.back().output = then(program.passes.back().output, *transform);
 
-      case config::scale_mode::centered:
-        return scale_matrix(div(physical_size, size));
+      } else if (leading_pass) {
+        program.input = then(program.input, *transform);
 
-      case config::scale_mode::stretch:
-        return scale_matrix(vec2{1.f});
+      } else {
+        program.passes.push_back({.filter = {}, .output = *transform});
+      }
     }
 
-    logcerr::warn("unsupported image scale mode");
-    return scale_matrix(vec2{1.f});
+    logcerr::verbose("compiled {} filter(s) into {} pass(es)",
+        filters.size(), program.passes.size() + (leading_pass ? 1 : 0));
+
+    return program;
+  }
+
+
+
+  void set_color_transform(const gl::program& shader, const color_transform& transform) {
+    glUniformMatrix4fv(shader.uniform("colorMatrix"), 1, GL_FALSE, transform.matrix.data());
+    glUniform4fv(shader.uniform("colorOffset"), 1, transform.offset.data());
+  }
+
+
+
+  [[nodiscard]] std::string with_color_transform(std::string_view source) {
+    return gl::insert_after_version(source, "#define COLOR_TRANSFORM\n");
   }
 }
 
 
 
+const gl::program& texture_generator::filter_shader(
+  shader shader_id,
+  bool   fused
+) const {
+  std::pair key{shader_id, fused};
+
+  if (auto index = filter_shader_cache_.find_index(key)) {
+    return filter_shader_cache_.value(*index);
+  }
+
+  auto variant = [fused](std::string_view source) {
+    return fused ? with_color_transform(source) : std::string{source};
+  };
+
+  switch (shader_id) {
+    case shader::box_blur:
+      return filter_shader_cache_.find_or_create(key,
+          resources::filter_vs(), variant(resources::filter_line_blur_fs()));
+    case shader::box_blur_running_sum:
+      return filter_shader_cache_.find_or_create(key,
+          variant(resources::filter_running_sum_cs()));
+    case shader::gaussian_blur:
+      return filter_shader_cache_.find_or_create(key,
+          resources::filter_vs(), variant(resources::filter_gaussian_blur_fs()));
+    case shader::color:
+      return filter_shader_cache_.find_or_create(key,
+          resources::filter_vs(), resources::filter_color_fs());
+    case shader::kawase_down:
+      return filter_shader_cache_.find_or_create(key,
+          resources::filter_vs(), variant(resources::filter_kawase_down_fs()));
+    case shader::kawase_up:
+      return filter_shader_cache_.find_or_create(key,
+          resources::filter_vs(), variant(resources::filter_kawase_up_fs()));
+    case shader::downsample:
+      return filter_shader_cache_.find_or_create(key,
+          resources::filter_vs(), variant(resources::filter_downsample_fs()));
+    case shader::rescale:
+      return filter_shader_cache_.find_or_create(key,
+          resources::rescale_texture_vs(), variant(resources::rescale_texture_fs()));
+  }
+
+  throw exception{"trying to use unknown filter shader"};
+}
+
+
+
 
 
-gl::texture texture_generator::create_base_texture(
+source_request texture_generator::source_request_for(
   const wayland::geometry& geometry,
   const config::brush&     brush
+) {
+  return {
+    .path   = brush.fgraph->path,
+    .target = {
+      .size  = geometry.physical_size(),
+      .scale = brush.fgraph->distribution.scale
+    }
+  };
+}
+
+
+
+render_target texture_generator::create_base_texture(
+  const wayland::geometry& geometry,
+  const config::brush&     brush,
+  const color_transform&   transform
 ) const {
-  auto texture = load_to_gl_texture(brush.fgraph->path);
+  auto request = source_request_for(geometry, brush);
+  const auto& texture = source_cache_.texture(request.path, request.target);
   texture.bind();
 
   auto s = gl::active_texture_size();
@@ -122,15 +318,13 @@ gl::texture texture_generator::create_base_texture(
       size, geometry.physical_size(),
       brush.solid[0], brush.solid[1], brush.solid[2], brush.solid[3]);
 
-  gl::texture output{
-    static_cast<GLsizei>(geometry.physical_size().x()),
-    static_cast<GLsizei>(geometry.physical_size().y()),
-    gl::texture::format::rgba8
-  };
+  auto output = render_target_pool_.acquire({
+    .width  = static_cast<GLsizei>(geometry.physical_size().x()),
+    .height = static_cast<GLsizei>(geometry.physical_size().y())
+  });
 
-  gl::framebuffer buffer{output};
   {
-    auto lock = buffer.bind();
+    auto lock = output.framebuffer.bind();
     glViewport(0, 0, geometry.physical_size().x(), geometry.physical_size().y());
 
     glClearColor(
@@ -141,12 +335,39 @@ gl::texture texture_generator::create_base_texture(
     );
     glClear(GL_COLOR_BUFFER_BIT);
 
-    draw_texture_.use();
     texture.bind();
     setup_texture_parameter(brush.fgraph->distribution);
+
+    // large sources come with mipmaps, so that minifying them does not alias
+    if (brush.fgraph->distribution.filter == config::scale_filter::linear
+        && gl::active_texture_levels() > 1) {
+      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    }
+
+    if (is_identity(transform)) {
+      draw_texture_.use();
+    } else {
+      const auto& shader = filter_shader(shader::rescale, true);
+      shader.use();
+      set_color_transform(shader, transform);
+      glUniform4f(shader.uniform("background"),
+          brush.solid[0] * brush.solid[3],
+          brush.solid[1] * brush.solid[3],
+          brush.solid[2] * brush.solid[3],
+          brush.solid[3]
+      );
+    }
+
     glUniformMatrix2fv(0, 1, GL_FALSE,
-        scale_matrix(brush.fgraph->distribution.scale, geometry, size).data());
+        scale_matrix(distribution_scale(brush.fgraph->distribution.scale, geometry, size))
+          .data());
+
+    // the fused shader blends on its own, since the transform applies to the result
+    if (is_identity(transform)) {
+      glEnable(GL_BLEND);
+    }
     quad_.draw();
+    glDisable(GL_BLEND);
   }
 
   return output;
@@ -159,8 +380,11 @@ gl::texture texture_generator::create_base_texture(
 gl::texture texture_generator::generate_from_existing(
   const gl::texture&              texture,
   const wayland::geometry&        geometry,
-  std::span<const config::filter> remaining_filters
+  std::span<const config::filter> filters,
+  size_t                          applied
 ) const {
+  auto remaining_filters = filters.subspan(applied);
+
   if (remaining_filters.empty()) {
     throw exception{"trying to create texture which already exists"};
   }
@@ -169,12 +393,39 @@ gl::texture texture_generator::generate_from_existing(
 
   setup_context(*context_);
 
-  auto output = apply_filter(texture, remaining_filters[0], geometry);
-  for (const auto& filter: remaining_filters.subspan(1)) {
-    output = apply_filter(output, filter, geometry);
+  texture.bind();
+  auto size = gl::active_texture_size();
+
+  // per-pixel filters work on a reduced texture just as well, which then already has
+  // the size it is stored at
+  bool per_pixel = std::ranges::all_of(remaining_filters, [](const auto& filter) {
+    return color_transform_of(filter).has_value();
+  });
+
+  bool needs_upsampling = !per_pixel
+                       && (std::cmp_not_equal(size.width,  geometry.physical_size().x())
+                        || std::cmp_not_equal(size.height, geometry.physical_size().y()));
+
+  auto program = compile(remaining_filters, needs_upsampling);
+
+  std::optional<render_target> output;
+  if (needs_upsampling) {
+    output.emplace(upsample(texture, geometry, program.input));
   }
 
-  return output;
+  for (const auto& pass: program.passes) {
+    const auto& input = output ? output->texture : texture;
+
+    auto next = pass.filter ? apply_filter(input, *pass.filter, pass.output, geometry)
+                            : apply_color_transform(input, pass.output);
+
+    if (output) {
+      render_target_pool_.recycle(std::move(*output));
+    }
+    output.emplace(std::move(next));
+  }
+
+  return finalize(std::move(*output), geometry, filters);
 }
 
 
@@ -189,20 +440,58 @@ gl::texture texture_generator::generate(
 
   logcerr::verbose("creating texture from scratch");
 
+  if (config::global_config().filter_backend() == config::filter_backend::cpu) {
+    return generate_on_cpu(geometry, brush);
+  }
+
   setup_context(*context_);
 
-  auto output = create_base_texture(geometry, brush);
-  for (const auto& filter: brush.fgraph->filters) {
-    output = apply_filter(output, filter, geometry);
+  auto program = compile(brush.fgraph->filters, true);
+
+  auto output = create_base_texture(geometry, brush, program.input);
+  for (const auto& pass: program.passes) {
+    ping_pong(output, render_target_pool_, [&](const auto& input) {
+        return pass.filter ? apply_filter(input, *pass.filter, pass.output, geometry)
+                           : apply_color_transform(input, pass.output); });
   }
 
-  return output;
+  return finalize(std::move(output), geometry, brush.fgraph->filters);
 }
 
 
 
 
 
+gl::texture texture_generator::generate_on_cpu(
+  const wayland::geometry& geometry,
+  const config::brush&     brush
+) const {
+  auto request = source_request_for(geometry, brush);
+  auto pixels  = cpu::create_base_image(geometry, brush,
+                   source_cache_.decoded(request.path, request.target));
+
+  const auto& filters = brush.fgraph->filters;
+
+  size_t applied{0};
+  for (; applied < filters.size() && cpu::supports(filters[applied]); ++applied) {
+    pixels = cpu::apply_filter(std::move(pixels), filters[applied]);
+  }
+
+  setup_context(*context_);
+
+  auto texture = cpu::to_texture(pixels);
+
+  if (applied == filters.size()) {
+    gl::texture_size size{.width = pixels.width, .height = pixels.height};
+    return finalize(render_target{std::move(texture), size, gl::texture::format::rgba8},
+        geometry, filters);
+  }
+
+  return generate_from_existing(texture, geometry, filters, applied);
+}
+
+
+
 texture_generator::~texture_generator() {
   try {
     if (context_) {
@@ -220,30 +509,41 @@ texture_generator::~texture_generator() {
 
 
 namespace {
-  [[nodiscard]] gl::texture line_blur(
-      const gl::texture& texture,
-      int                samples,
-      float              dx,
-      float              dy,
-      float              dithering,
-      const gl::program& shader,
-      const gl::mesh&    quad
+  // from this many samples per side on, a running sum is cheaper than sampling every texel
+  constexpr int running_sum_threshold{16};
+
+  // shortest part of a line which one invocation of the running sum works through
+  constexpr GLint running_sum_min_segment{128};
+
+
+
+  [[nodiscard]] render_target line_blur(
+      const gl::texture&     texture,
+      int                    samples,
+      float                  dx,
+      float                  dy,
+      float                  dithering,
+      const color_transform& transform,
+      const gl::program&     shader,
+      const gl::sampler&     sampler,
+      const gl::mesh&        quad,
+      render_target_pool&    pool
   ) {
     texture.bind();
     auto size = gl::active_texture_size();
-    gl::texture output{size};
-    gl::framebuffer fb{output};
+    auto output = pool.acquire(size);
 
-    auto lock = fb.bind();
+    auto lock = output.framebuffer.bind();
 
     glViewport(0, 0, size.width, size.height);
 
     texture.bind();
-
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_MIRRORED_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_MIRRORED_REPEAT);
+    auto sampler_lock = sampler.bind();
 
     shader.use();
+    if (!is_identity(transform)) {
+      set_color_transform(shader, transform);
+    }
     glUniform1f(shader.uniform("dithering"), dithering / 255.f);
     glUniform1i(shader.uniform("samples"), samples);
     glUniform2f(shader.uniform("direction"),
@@ -256,12 +556,61 @@ namespace {
 
 
 
-  [[nodiscard]] gl::texture box_blur(
+  [[nodiscard]] render_target running_sum_blur(
+      const gl::texture&     texture,
+      int                    samples,
+      int                    dx,
+      int                    dy,
+      float                  dithering,
+      const color_transform& transform,
+      const gl::program&     shader,
+      render_target_pool&    pool
+  ) {
+    texture.bind();
+    auto size = gl::active_texture_size();
+    auto output = pool.acquire(size);
+
+    shader.use();
+    if (!is_identity(transform)) {
+      set_color_transform(shader, transform);
+    }
+    glUniform1f(shader.uniform("dithering"), dithering / 255.f);
+
+    // each segment sets up its window with 2 * samples + 1 fetches and then slides it
+    // along two fetches per texel, so segments are kept several windows long
+    GLint segment = std::max(running_sum_min_segment, 4 * (2 * samples + 1));
+
+    glUniform1i(shader.uniform("samples"), samples);
+    glUniform1i(shader.uniform("segment"), segment);
+    glUniform2i(shader.uniform("direction"), dx, dy);
+
+    glActiveTexture(GL_TEXTURE0);
+    texture.bind();
+    glBindImageTexture(0, output.texture.get(), 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA8);
+
+    static constexpr GLuint local_size{64};
+    GLuint lines  = dx != 0 ? size.height : size.width;
+    GLuint length = dx != 0 ? size.width  : size.height;
+    glDispatchCompute((lines + local_size - 1) / local_size,
+        (length + segment - 1) / static_cast<GLuint>(segment), 1);
+
+    glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT | GL_TEXTURE_UPDATE_BARRIER_BIT
+                    | GL_FRAMEBUFFER_BARRIER_BIT);
+
+    glBindImageTexture(0, 0, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA8);
+
+    return output;
+  }
+
+
+
+  template<typename LineBlur>
+  [[nodiscard]] render_target box_blur(
       const gl::texture&             texture,
       const config::box_blur_filter& filter,
-      const wayland::geometry&       /*geometry*/,
-      const gl::program&             shader,
-      const gl::mesh&                quad
+      const color_transform&         transform,
+      const LineBlur&                blur_line,
+      render_target_pool&            pool
   ) {
     if (filter.iterations == 0) {
       throw exception{"unable to apply box blur filter with 0 iterations"};
@@ -270,56 +619,608 @@ namespace {
     logcerr::verbose("applying box blur filter with scale {:#} and {} iterations",
         filter.size * 2 + vec2{1u}, filter.iterations);
 
-    auto output = line_blur(line_blur(texture, filter.size.x(), 1.f, 0.f,
-                                      filter.dithering, shader, quad),
-                    filter.size.y(), 0.f, 1.f, filter.dithering, shader, quad);
+    // only the very last pass applies the color transform
+    auto transform_after = [&](unsigned int iteration) -> const color_transform& {
+      static const color_transform identity{};
+      return iteration + 1 == filter.iterations ? transform : identity;
+    };
+
+    auto output = blur_line(texture, filter.size.x(), 1, 0, color_transform{});
+    ping_pong(output, pool, [&](const auto& input) {
+        return blur_line(input, filter.size.y(), 0, 1, transform_after(0)); });
 
     for (unsigned int i = 1; i < filter.iterations; ++i) {
-      output = line_blur(line_blur(output, filter.size.x(), 1.f, 0.f,
-                                   filter.dithering, shader, quad),
-                    filter.size.y(), 0.f, 1.f, filter.dithering, shader, quad);
+      ping_pong(output, pool, [&](const auto& input) {
+          return blur_line(input, filter.size.x(), 1, 0, color_transform{}); });
+      ping_pong(output, pool, [&](const auto& input) {
+          return blur_line(input, filter.size.y(), 0, 1, transform_after(i)); });
     }
     return output;
   }
+
+
+
+  constexpr size_t gaussian_max_taps{128};
+
+  struct gaussian_kernel {
+    std::vector<float> weights;
+    std::vector<float> offsets;
+  };
+
+
+
+  [[nodiscard]] float gaussian_sigma(uint32_t radius) {
+    // same standard deviation as `blur` (box blur with two iterations)
+    auto r = static_cast<float>(radius);
+    return std::sqrt(2.f * r * (r + 1.f) / 3.f);
+  }
+
+
+
+  [[nodiscard]] gaussian_kernel gaussian_kernel_for(float sigma) {
+    auto half_width = static_cast<int>(std::ceil(3.f * sigma));
+
+    std::vector<double> weights(half_width + 1);
+    double total{0.0};
+    for (int i = 0; i <= half_width; ++i) {
+      weights[i] = std::exp(-0.5 * i * i / (sigma * sigma));
+      total += (i == 0 ? 1.0 : 2.0) * weights[i];
+    }
+
+    gaussian_kernel kernel;
+    kernel.weights.push_back(static_cast<float>(weights[0] / total));
+    kernel.offsets.push_back(0.f);
+
+    for (int i = 1; i <= half_width; i += 2) {
+      double a = weights[i];
+      double b = i + 1 <= half_width ? weights[i + 1] : 0.0;
+
+      kernel.weights.push_back(static_cast<float>((a + b) / total));
+      kernel.offsets.push_back(static_cast<float>((i * a + (i + 1) * b) / (a + b)));
+    }
+
+    return kernel;
+  }
+
+
+
+  [[nodiscard]] render_target gaussian_line_blur(
+      const gl::texture&     texture,
+      const gaussian_kernel& kernel,
+      float                  dx,
+      float                  dy,
+      float                  dithering,
+      const color_transform& transform,
+      const gl::program&     shader,
+      const gl::sampler&     sampler,
+      const gl::mesh&        quad,
+      render_target_pool&    pool
+  ) {
+    texture.bind();
+    auto size = gl::active_texture_size();
+    auto output = pool.acquire(size);
+
+    auto lock = output.framebuffer.bind();
+
+    glViewport(0, 0, size.width, size.height);
+
+    texture.bind();
+    auto sampler_lock = sampler.bind();
+
+    shader.use();
+    if (!is_identity(transform)) {
+      set_color_transform(shader, transform);
+    }
+    glUniform1f(shader.uniform("dithering"), dithering / 255.f);
+    glUniform1i(shader.uniform("taps"), static_cast<GLint>(kernel.weights.size()));
+    glUniform1fv(shader.uniform("weights"), kernel.weights.size(), kernel.weights.data());
+    glUniform1fv(shader.uniform("offsets"), kernel.offsets.size(), kernel.offsets.data());
+    glUniform2f(shader.uniform("direction"),
+        dx / static_cast<float>(size.width), dy / static_cast<float>(size.height));
+
+    quad.draw();
+
+    return output;
+  }
+
+
+
+  [[nodiscard]] render_target gaussian_blur(
+      const gl::texture&                  texture,
+      const config::gaussian_blur_filter& filter,
+      const color_transform&              transform,
+      const gl::program&                  shader,
+      const gl::program&                  fused,
+      const gl::sampler&                  sampler,
+      const gl::mesh&                     quad,
+      render_target_pool&                 pool
+  ) {
+    logcerr::verbose("applying gaussian blur filter with radius {:#}", filter.size);
+
+    std::optional<render_target> output;
+
+    for (auto [radius, dx, dy]: {std::tuple{filter.size.x(), 1.f, 0.f},
+                                 std::tuple{filter.size.y(), 0.f, 1.f}}) {
+      if (radius == 0) {
+        continue;
+      }
+
+      // very wide kernels are split into several narrower passes, since the
+      // variances of consecutive gaussian blurs add up
+      auto sigma = gaussian_sigma(radius);
+      unsigned int passes{1};
+      while (std::ceil(3.f * sigma / std::sqrt(static_cast<float>(passes)))
+               > 2.f * (gaussian_max_taps - 1)) {
+        ++passes;
+      }
+
+      auto kernel = gaussian_kernel_for(sigma / std::sqrt(static_cast<float>(passes)));
+
+      bool last_direction = dy != 0.f || filter.size.y() == 0;
+
+      for (unsigned int i = 0; i < passes; ++i) {
+        bool last = last_direction && i + 1 == passes;
+
+        auto next = gaussian_line_blur(output ? output->texture : texture, kernel, dx, dy,
+                      filter.dithering, last ? transform : color_transform{},
+                      last ? fused : shader, sampler, quad, pool);
+
+        if (output) {
+          pool.recycle(std::move(*output));
+        }
+        output.emplace(std::move(next));
+      }
+    }
+
+    if (!output) {
+      throw exception{"unable to apply gaussian blur filter with radius 0"};
+    }
+
+    return std::move(*output);
+  }
+
+
+
+  struct kawase_parameters {
+    unsigned int levels;
+    float        offset;
+  };
+
+  [[nodiscard]] kawase_parameters kawase_parameters_for(unsigned int radius) {
+    // each level doubles the spread; matches the standard deviation of `blur` (box blur
+    // with two iterations) for the same radius
+    static constexpr float base_radius{1.8f};
+
+    unsigned int levels{1};
+    while (static_cast<float>(1u << levels) * base_radius * 2.f
+             <= static_cast<float>(radius)) {
+      ++levels;
+    }
+
+    return {
+      .levels = levels,
+      .offset = static_cast<float>(radius) / (static_cast<float>(1u << levels) * base_radius)
+    };
+  }
+
+
+
+  void kawase_pass(
+      const gl::texture&   input,
+      const render_target& output,
+      float                offset,
+      const gl::program&   shader,
+      const gl::sampler&   sampler,
+      const gl::mesh&      quad
+  ) {
+    input.bind();
+    auto in_size = gl::active_texture_size();
+
+    auto lock = output.framebuffer.bind();
+
+    glViewport(0, 0, output.size.width, output.size.height);
+
+    input.bind();
+    auto sampler_lock = sampler.bind();
+    shader.use();
+    glUniform2f(shader.uniform("offset"),
+        offset / static_cast<float>(in_size.width),
+        offset / static_cast<float>(in_size.height));
+
+    quad.draw();
+  }
+
+
+
+  // the upsample passes write twice the size of their input
+  void set_output_size(const gl::program& shader, gl::texture_size size) {
+    shader.use();
+    glUniform2f(shader.uniform("outputSize"),
+        static_cast<float>(size.width), static_cast<float>(size.height));
+  }
+
+
+
+  [[nodiscard]] render_target kawase_blur(
+      const gl::texture&                texture,
+      const config::kawase_blur_filter& filter,
+      const color_transform&            transform,
+      const gl::program&                down,
+      const gl::program&                up,
+      const gl::program&                fused_up,
+      const gl::sampler&                sampler,
+      const gl::mesh&                   quad,
+      render_target_pool&               pool
+  ) {
+    if (filter.radius == 0) {
+      throw exception{"unable to apply kawase blur filter with radius 0"};
+    }
+
+    auto [levels, offset] = kawase_parameters_for(filter.radius);
+
+    logcerr::verbose("applying kawase blur filter with radius {} ({} levels, offset {:.2})",
+        filter.radius, levels, offset);
+
+    texture.bind();
+    std::vector<gl::texture_size> sizes{gl::active_texture_size()};
+
+    for (unsigned int i = 0; i < levels; ++i) {
+      sizes.push_back({
+        .width  = std::max(1, (sizes.back().width  + 1) / 2),
+        .height = std::max(1, (sizes.back().height + 1) / 2)
+      });
+    }
+
+    std::vector<render_target> pyramid;
+    pyramid.reserve(levels);
+
+    down.use();
+
+    const gl::texture* source = &texture;
+    for (unsigned int i = 1; i <= levels; ++i) {
+      kawase_pass(*source, pyramid.emplace_back(pool.acquire(sizes[i])), offset, down,
+          sampler, quad);
+      source = &pyramid.back().texture;
+    }
+
+
+
+    up.use();
+    glUniform1f(up.uniform("dithering"), 0.f);
+
+    for (unsigned int i = levels; i > 1; --i) {
+      auto output = pool.acquire(sizes[i - 1]);
+      set_output_size(up, sizes[i - 1]);
+      kawase_pass(pyramid[i - 1].texture, output, offset, up, sampler, quad);
+
+      pool.recycle(std::move(pyramid[i - 1]));
+      pool.recycle(std::move(pyramid[i - 2]));
+      pyramid[i - 2] = std::move(output);
+    }
+
+    auto output = pool.acquire(sizes[0]);
+
+    fused_up.use();
+    if (!is_identity(transform)) {
+      set_color_transform(fused_up, transform);
+    }
+    glUniform1f(fused_up.uniform("dithering"), filter.dithering / 255.f);
+    set_output_size(fused_up, sizes[0]);
+    kawase_pass(pyramid[0].texture, output, offset, fused_up, sampler, quad);
+
+    pool.recycle(std::move(pyramid[0]));
+
+    return output;
+  }
 }
 
 
 
 
 
-gl::texture texture_generator::apply_filter(
+render_target texture_generator::apply_filter(
   const gl::texture&       texture,
   const config::filter&    filter,
-  const wayland::geometry& geometry
+  const color_transform&   transform,
+  const wayland::geometry& /*geometry*/
 ) const {
+  bool fused = !is_identity(transform);
+
   if (const auto *bblur = std::get_if<config::box_blur_filter>(&filter)) {
-    return box_blur(texture, *bblur, geometry,
-        filter_shader_cache_.find_or_create(shader::box_blur,
-          resources::filter_vs(), resources::filter_line_blur_fs()),
-        quad_);
+    return box_blur(texture, *bblur, transform,
+      [this, dithering = bblur->dithering](const gl::texture& input, int samples,
+                                           int dx, int dy, const color_transform& t) {
+        if (use_running_sum_ && samples >= running_sum_threshold
+            && epoxy_gl_version() >= 43) {
+          return running_sum_blur(input, samples, dx, dy, dithering, t,
+              filter_shader(shader::box_blur_running_sum, !is_identity(t)),
+              render_target_pool_);
+        }
+
+        return line_blur(input, samples, static_cast<float>(dx), static_cast<float>(dy),
+            dithering, t, filter_shader(shader::box_blur, !is_identity(t)),
+            line_sampler_, quad_, render_target_pool_);
+      },
+      render_target_pool_);
+  }
+
+  if (const auto *gblur = std::get_if<config::gaussian_blur_filter>(&filter)) {
+    // both programs must exist before taking references into the cache
+    std::ignore = filter_shader(shader::gaussian_blur);
+    std::ignore = filter_shader(shader::gaussian_blur, fused);
+
+    return gaussian_blur(texture, *gblur, transform,
+        filter_shader(shader::gaussian_blur), filter_shader(shader::gaussian_blur, fused),
+        blur_sampler_, quad_, render_target_pool_);
   }
 
+  if (const auto *kblur = std::get_if<config::kawase_blur_filter>(&filter)) {
+    // all programs must exist before taking references into the cache
+    std::ignore = filter_shader(shader::kawase_down);
+    std::ignore = filter_shader(shader::kawase_up);
+    std::ignore = filter_shader(shader::kawase_up, fused);
+
+    return kawase_blur(texture, *kblur, transform,
+        filter_shader(shader::kawase_down), filter_shader(shader::kawase_up),
+        filter_shader(shader::kawase_up, fused), blur_sampler_, quad_, render_target_pool_);
+  }
+
+  throw exception{"trying to use unimplemented filter"};
+}
+
+
+
+render_target texture_generator::apply_color_transform(
+  const gl::texture&     texture,
+  const color_transform& transform
+) const {
+  logcerr::verbose("applying color transform");
 
   texture.bind();
   auto size = gl::active_texture_size();
-  gl::texture output{size};
-  gl::framebuffer fb{output};
-  {
-    auto lock = fb.bind();
-    glViewport(0, 0, size.width, size.height);
+  auto output = render_target_pool_.acquire(size);
+
+  auto lock = output.framebuffer.bind();
+  glViewport(0, 0, size.width, size.height);
+
+  texture.bind();
+
+  const auto& shader = filter_shader(shader::color);
+  shader.use();
+  set_color_transform(shader, transform);
+
+  quad_.draw();
+
+  return output;
+}
+
+
+
+
+
+namespace {
+  // blurred textures have hardly any detail left, so they are stored at a reduced
+  // resolution and upsampled with linear filtering when drawn
+  constexpr float    storage_sigma_per_texel{8.f};
+  constexpr uint32_t max_storage_reduction  {4};
+
+  [[nodiscard]] uint32_t storage_reduction(float sigma) {
+    return std::clamp(std::bit_floor(static_cast<uint32_t>(sigma / storage_sigma_per_texel)),
+        1u, max_storage_reduction);
+  }
+
 
+
+  [[nodiscard]] float box_blur_sigma(uint32_t radius, unsigned int iterations) {
+    auto r = static_cast<float>(radius);
+    return std::sqrt(static_cast<float>(iterations) * r * (r + 1.f) / 3.f);
+  }
+
+
+
+  // per-pixel filters are applied by the pass in front of them
+  [[nodiscard]] std::span<const config::filter> without_trailing_color_transforms(
+      std::span<const config::filter> filters
+  ) {
+    while (!filters.empty() && color_transform_of(filters.back())) {
+      filters = filters.first(filters.size() - 1);
+    }
+    return filters;
+  }
+
+
+
+  [[nodiscard]] vec2<uint32_t> storage_reduction(std::span<const config::filter> filters) {
+    filters = without_trailing_color_transforms(filters);
+
+    if (filters.empty()) {
+      return vec2{1u};
+    }
+
+    const auto& filter = filters.back();
+
+    if (const auto *bblur = std::get_if<config::box_blur_filter>(&filter)) {
+      return {
+        storage_reduction(box_blur_sigma(bblur->size.x(), bblur->iterations)),
+        storage_reduction(box_blur_sigma(bblur->size.y(), bblur->iterations))
+      };
+    }
+
+    if (const auto *gblur = std::get_if<config::gaussian_blur_filter>(&filter)) {
+      return {
+        storage_reduction(gaussian_sigma(gblur->size.x())),
+        storage_reduction(gaussian_sigma(gblur->size.y()))
+      };
+    }
+
+    if (const auto *kblur = std::get_if<config::kawase_blur_filter>(&filter)) {
+      return vec2{storage_reduction(gaussian_sigma(kblur->radius))};
+    }
+
+    return vec2{1u};
+  }
+
+
+
+  [[nodiscard]] float dithering_of(const config::filter& filter) {
+    return std::visit([](const auto& f) {
+      if constexpr (requires { f.dithering; }) {
+        return f.dithering;
+      } else {
+        return 0.f;
+      }
+    }, filter);
+  }
+
+
+
+  [[nodiscard]] GLsizei reduce(GLsizei size, uint32_t factor) {
+    return factor > 1 ? (size + 1) / 2 : size;
+  }
+
+
+
+  [[nodiscard]] render_target downsample(
+      const gl::texture&  texture,
+      vec2<uint32_t>      factor,
+      float               dithering,
+      const gl::program&  shader,
+      const gl::sampler&  sampler,
+      const gl::mesh&     quad,
+      render_target_pool& pool
+  ) {
     texture.bind();
+    auto size = gl::active_texture_size();
 
-    if (std::holds_alternative<config::invert_filter>(filter)) {
-      logcerr::verbose("applying invert filter");
-      filter_shader_cache_.find_or_create(shader::invert,
-          resources::filter_vs(), resources::filter_invert_fs()).use();
+    auto output = pool.acquire({
+      .width  = reduce(size.width,  factor.x()),
+      .height = reduce(size.height, factor.y())
+    });
 
-    } else {
-      throw exception{"trying to use unimplemented filter"};
+    auto lock = output.framebuffer.bind();
+
+    glViewport(0, 0, output.size.width, output.size.height);
+
+    texture.bind();
+    auto sampler_lock = sampler.bind();
+    shader.use();
+    glUniform1f(shader.uniform("dithering"), dithering / 255.f);
+
+    quad.draw();
+
+    return output;
+  }
+}
+
+
+
+namespace {
+  [[nodiscard]] gl::texture_size storage_size_of(
+      const wayland::geometry&        geometry,
+      std::span<const config::filter> filters
+  ) {
+    gl::texture_size size{
+      .width  = static_cast<GLsizei>(geometry.physical_size().x()),
+      .height = static_cast<GLsizei>(geometry.physical_size().y())
+    };
+
+    for (auto factor = storage_reduction(filters); factor != vec2{1u};
+         factor = max(factor / 2u, vec2{1u})) {
+      size.width  = reduce(size.width,  factor.x());
+      size.height = reduce(size.height, factor.y());
     }
-    quad_.draw();
+
+    return size;
   }
+}
+
+
+
+gl::texture_size texture_generator::storage_size(
+  const wayland::geometry& geometry,
+  const config::brush&     brush
+) {
+  if (!brush.fgraph) {
+    return {
+      .width  = static_cast<GLsizei>(geometry.physical_size().x()),
+      .height = static_cast<GLsizei>(geometry.physical_size().y())
+    };
+  }
+
+  return storage_size_of(geometry, brush.fgraph->filters);
+}
+
+
+
+render_target texture_generator::upsample(
+  const gl::texture&       texture,
+  const wayland::geometry& geometry,
+  const color_transform&   transform
+) const {
+  logcerr::verbose("upsampling reduced texture to {:#}", geometry.physical_size());
+
+  auto output = render_target_pool_.acquire({
+    .width  = static_cast<GLsizei>(geometry.physical_size().x()),
+    .height = static_cast<GLsizei>(geometry.physical_size().y())
+  });
+
+  auto lock = output.framebuffer.bind();
+  glViewport(0, 0, output.size.width, output.size.height);
+
+  if (is_identity(transform)) {
+    draw_texture_.use();
+  } else {
+    const auto& shader = filter_shader(shader::rescale, true);
+    shader.use();
+    set_color_transform(shader, transform);
+    glUniform4f(shader.uniform("background"), 0.f, 0.f, 0.f, 0.f);
+  }
+
+  texture.bind();
+  auto sampler_lock = resample_sampler_.bind();
+
+  static constexpr std::array<float, 4> identity{1.f, 0.f, 0.f, 1.f};
+  glUniformMatrix2fv(0, 1, GL_FALSE, identity.data());
+
+  quad_.draw();
 
   return output;
 }
+
+
+
+gl::texture texture_generator::finalize(
+  render_target&&                 output,
+  const wayland::geometry&        geometry,
+  std::span<const config::filter> filters
+) const {
+  auto factor = storage_reduction(filters);
+
+  if (factor != vec2{1u}) {
+    // trailing per-pixel filters applied to a reduced prefix leave it at its stored size
+    auto target = storage_size_of(geometry, filters);
+    if (output.size.width != target.width || output.size.height != target.height) {
+      logcerr::verbose("storing texture at 1/{:#} resolution", factor);
+
+      const auto& shader = filter_shader(shader::downsample);
+
+      for (; factor != vec2{1u}; factor = max(factor / 2u, vec2{1u})) {
+        auto last = max(factor / 2u, vec2{1u}) == vec2{1u};
+
+        ping_pong(output, render_target_pool_, [&](const auto& input) {
+            return downsample(input, factor,
+                last ? dithering_of(without_trailing_color_transforms(filters).back()) : 0.f,
+                shader, resample_sampler_, quad_, render_target_pool_); });
+      }
+    }
+
+    // upsampled when drawn
+    output.texture.bind();
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  }
+
+  return std::move(output.texture);
+}
@@ -1,77 +1,236 @@
+#include "wallpablur/config/config.hpp"
 #include "wallpablur/config/filter.hpp"
 #include "wallpablur/texture-provider.hpp"
 #include "wallpablur/wayland/geometry.hpp"
 
 #include <algorithm>
+#include <chrono>
+#include <functional>
+#include <tuple>
 
 #include <logcerr/log.hpp>
 
+#include <gl/fence.hpp>
 
 
-using key = std::pair<wayland::geometry, config::brush>;
+
+namespace {
+  [[nodiscard]] std::optional<disk_cache> make_disk_cache() {
+    if (!config::global_config().disk_cache()) {
+      return {};
+    }
+
+    if (auto directory = cache_directory()) {
+      logcerr::verbose("using disk cache in {}", directory->string());
+      return disk_cache{
+        std::move(*directory),
+        config::global_config().filter_backend(),
+        static_cast<size_t>(config::global_config().disk_cache_size_mb()) << 20u
+      };
+    }
+
+    logcerr::warn("unable to determine cache directory, disabling disk cache");
+    return {};
+  }
+
+
+
+  [[nodiscard]] std::unique_ptr<file_watcher> make_file_watcher() {
+    if (!config::global_config().watch_images()) {
+      return {};
+    }
+
+    try {
+      return std::make_unique<file_watcher>();
+    } catch (std::exception& ex) {
+      logcerr::warn("unable to watch images for changes:\n{}", ex.what());
+      return {};
+    }
+  }
+}
 
 
 
 texture_provider::texture_provider(std::shared_ptr<egl::context> context) :
-  texture_generator_{std::move(context)}
+  context_      {std::move(context)},
+  disk_cache_   {make_disk_cache()},
+  file_watcher_ {make_file_watcher()},
+  memory_budget_{static_cast<size_t>(config::global_config().texture_memory_budget_mb())
+                   << 20u},
+
+  worker_thread_{[this] (const std::stop_token& stoken) {
+    logcerr::thread_name("texture");
+    logcerr::debug("entering texture worker loop");
+    worker_loop(stoken);
+    logcerr::debug("exiting texture worker loop");
+  }}
 {}
 
 
 
+texture_provider::~texture_provider() = default;
 
 
-void texture_provider::cleanup() {
-  for (size_t i = 0; i < cache_.size();) {
-    if (cache_.value(i).expired()) {
-      cache_.erase(i);
-    } else {
-      ++i;
+
+
+
+namespace {
+  template<typename T>
+  void hash_combine(size_t& seed, const T& value) {
+    seed ^= std::hash<T>{}(value) + 0x9e3779b9 + (seed << 6u) + (seed >> 2u);
+  }
+}
+
+
+
+size_t texture_provider::key_hash::operator()(const key& k) const {
+  size_t seed{0};
+
+  hash_combine(seed, k.size.x());
+  hash_combine(seed, k.size.y());
+
+  for (auto c: k.brush.solid) {
+    hash_combine(seed, c);
+  }
+
+  if (const auto& fg = k.brush.fgraph) {
+    hash_combine(seed, std::filesystem::hash_value(fg->path));
+    hash_combine(seed, fg->distribution.scale);
+    hash_combine(seed, fg->distribution.wrap_x);
+    hash_combine(seed, fg->distribution.wrap_y);
+    hash_combine(seed, fg->distribution.filter);
+
+    // filter parameters are left to the equality comparison
+    for (const auto& filter: fg->filters) {
+      hash_combine(seed, filter.index());
     }
   }
+
+  return seed;
 }
 
 
 
 
 
-namespace {
-  [[nodiscard]] bool starts_with(
-      const config::filter_graph& fg,
-      const config::filter_graph& start
-  ) {
-    if (fg.path != start.path ||
-        fg.distribution != start.distribution ||
-        fg.filters.size() < start.filters.size()) {
-      return false;
+void texture_provider::cleanup() {
+  auto now = ++tick_;
+
+  size_t usage{0};
+
+  for (auto it = cache_.begin(); it != cache_.end();) {
+    auto& entry = it->second;
+
+    if (entry.pending.valid() &&
+        entry.pending.wait_for(std::chrono::seconds{0}) == std::future_status::ready) {
+      entry.texture = entry.pending.get();
+      entry.pending = {};
     }
 
-    return std::equal(start.filters.begin(), start.filters.end(), fg.filters.begin());
+    if (!entry.pending.valid() &&
+        (!entry.texture || (entry.intermediate && entry.texture.use_count() == 1))) {
+      it = cache_.erase(it);
+      continue;
+    }
+
+    if (entry.texture) {
+      usage += entry.bytes;
+
+      // someone besides the cache is holding on to it, i.e. it is being displayed
+      if (entry.texture.use_count() > 1) {
+        entry.last_used = now;
+      }
+    }
+
+    ++it;
   }
 
+  if (memory_budget_ > 0 && usage > memory_budget_) {
+    evict(usage);
+  } else if (usage != memory_usage_) {
+    memory_usage_ = usage;
+    logcerr::verbose("texture memory usage: {} MiB", usage >> 20u);
+  }
+}
 
 
-  [[nodiscard]] size_t best_fit(
-      std::span<key>                   list,
-      const wayland::geometry&         geometry,
-      const config::brush&             brush
-  ) {
-    size_t best{list.size()};
-    size_t match_length{0};
 
-    for (size_t i = 0; i < list.size(); ++i) {
-      if (!list[i].first.same_physical_size(geometry) ||
-          list[i].second.solid != brush.solid) {
+void texture_provider::reload_changed_sources() {
+  if (!file_watcher_) {
+    return;
+  }
+
+  auto changed = file_watcher_->changes();
+  if (changed.empty()) {
+    return;
+  }
+
+  for (const auto& path: changed) {
+    logcerr::verbose("{} changed on disk, regenerating textures", path.string());
+
+    ++source_versions_.find_or_create(path, 0);
+
+    // textures which are currently displayed stay alive until they are replaced
+    std::erase_if(cache_, [&path](const auto& item) {
+      const auto& fgraph = item.first.brush.fgraph;
+      return fgraph && fgraph->path == path;
+    });
+  }
+
+  cleanup();
+}
+
+
+
+uint64_t texture_provider::source_version(const config::brush& brush) {
+  if (!brush.fgraph) {
+    return 0;
+  }
+
+  if (auto index = source_versions_.find_index(brush.fgraph->path)) {
+    return source_versions_.value(*index);
+  }
+
+  return 0;
+}
+
+
+
+void texture_provider::evict(size_t usage) {
+  size_t count{0};
+
+  while (usage > memory_budget_) {
+    auto lru = cache_.end();
+
+    for (auto it = cache_.begin(); it != cache_.end(); ++it) {
+      const auto& entry = it->second;
+
+      if (entry.pending.valid() || !entry.texture || entry.texture.use_count() > 1) {
         continue;
       }
 
-      if (starts_with(*brush.fgraph, *list[i].second.fgraph) &&
-          list[i].second.fgraph->filters.size() + 1 > match_length) {
-        match_length = list[i].second.fgraph->filters.size() + 1;
-        best = i;
+      if (lru == cache_.end() || entry.last_used < lru->second.last_used) {
+        lru = it;
       }
     }
 
-    return best;
+    if (lru == cache_.end()) {
+      break;
+    }
+
+    usage -= lru->second.bytes;
+    cache_.erase(lru);
+    ++count;
+  }
+
+  memory_usage_ = usage;
+
+  logcerr::verbose("texture memory usage: {} MiB after evicting {} texture(s)",
+      usage >> 20u, count);
+
+  if (usage > memory_budget_) {
+    logcerr::warn("textures in use exceed the texture memory budget ({} MiB > {} MiB)",
+        usage >> 20u, memory_budget_ >> 20u);
   }
 }
 
@@ -79,8 +238,81 @@ namespace {
 
 
 
+namespace {
+  [[nodiscard]] texture_provider::texture_future make_ready(
+      std::shared_ptr<gl::texture> texture
+  ) {
+    std::promise<std::shared_ptr<gl::texture>> promise;
+    promise.set_value(std::move(texture));
+    return promise.get_future().share();
+  }
+
+
+
+  [[nodiscard]] config::brush description_of(const config::brush& brush) {
+    config::brush output;
+    output.solid  = brush.solid;
+    output.fgraph = brush.fgraph;
+    return output;
+  }
+
+
+
+  [[nodiscard]] config::brush prefix_of(const config::brush& brush, size_t length) {
+    auto output = description_of(brush);
+    output.fgraph->filters.resize(length);
+    return output;
+  }
+
+
+
+  [[nodiscard]] bool same_source(const config::brush& lhs, const config::brush& rhs) {
+    return lhs.solid == rhs.solid
+      && lhs.fgraph->path == rhs.fgraph->path
+      && lhs.fgraph->distribution == rhs.fgraph->distribution;
+  }
+
+
+
+  [[nodiscard]] size_t common_prefix_length(
+      const config::brush& lhs,
+      const config::brush& rhs
+  ) {
+    const auto& a = lhs.fgraph->filters;
+    const auto& b = rhs.fgraph->filters;
+
+    return std::ranges::mismatch(a, b).in1 - a.begin();
+  }
+}
+
+
+
 
-std::shared_ptr<gl::texture> texture_provider::get(
+
+std::optional<std::pair<texture_provider::texture_future, size_t>>
+texture_provider::longest_prefix(
+  const wayland::geometry& geometry,
+  const config::brush&     brush
+) const {
+  for (size_t length = brush.fgraph->filters.size(); length-- > 0;) {
+    auto it = cache_.find(key{geometry.physical_size(), prefix_of(brush, length)});
+
+    if (it == cache_.end()) {
+      continue;
+    }
+
+    const auto& base = it->second;
+    return std::pair{base.pending.valid() ? base.pending : make_ready(base.texture), length};
+  }
+
+  return {};
+}
+
+
+
+
+
+texture_provider::texture_future texture_provider::get(
   const wayland::geometry& geometry,
   const config::brush&     brush
 ) {
@@ -91,39 +323,239 @@ std::shared_ptr<gl::texture> texture_provider::get(
 
   cleanup();
 
-  size_t ix = std::ranges::find_if(cache_.keys(), [&brush, &geometry](const auto& tp){
-                  return tp.first.same_physical_size(geometry) && tp.second == brush; })
-                - cache_.keys().begin();
+  return request(geometry, brush, false);
+}
+
+
+
+void texture_provider::prepare(
+  const wayland::geometry&              geometry,
+  std::span<const config::brush* const> brushes
+) {
+  // brushes which are already on disk are loaded as a whole
+  std::vector<const config::brush*> missing;
+
+  for (const auto* brush: brushes) {
+    if (brush->fgraph && !(disk_cache_ && disk_cache_->contains(geometry, *brush))) {
+      missing.emplace_back(brush);
+    }
+  }
+
+  std::vector<config::brush> prefixes;
+
+  for (size_t i = 0; i < missing.size(); ++i) {
+    for (size_t j = i + 1; j < missing.size(); ++j) {
+      if (!same_source(*missing[i], *missing[j])) {
+        continue;
+      }
+
+      auto prefix = prefix_of(*missing[i], common_prefix_length(*missing[i], *missing[j]));
+      if (std::ranges::find(prefixes, prefix) == prefixes.end()) {
+        prefixes.emplace_back(std::move(prefix));
+      }
+    }
+  }
+
+  if (prefixes.empty()) {
+    return;
+  }
+
+  logcerr::verbose("sharing {} filter chain prefix(es) at {:#}", prefixes.size(),
+      geometry.physical_size());
+
+  cleanup();
+
+  // shorter prefixes first, so that longer ones can be built on top of them
+  std::ranges::sort(prefixes, {}, [](const auto& b) { return b.fgraph->filters.size(); });
+
+  for (const auto& prefix: prefixes) {
+    // a prefix which is displayed itself needs to end up on disk as well
+    bool is_brush = std::ranges::any_of(brushes, [&prefix](const auto* brush) {
+      return *brush == prefix;
+    });
+
+    std::ignore = request(geometry, prefix, !is_brush);
+  }
+}
+
 
-  if (ix < cache_.size()) {
-    return cache_.value(ix).lock();
+
+texture_provider::texture_future texture_provider::request(
+  const wayland::geometry& geometry,
+  const config::brush&     brush,
+  bool                     intermediate
+) {
+  key k{geometry.physical_size(), description_of(brush)};
+
+  if (file_watcher_) {
+    file_watcher_->watch(brush.fgraph->path);
   }
 
+  if (auto it = cache_.find(k); it != cache_.end()) {
+    auto& entry = it->second;
+    entry.last_used = ++tick_;
 
+    if (entry.intermediate && !intermediate) {
+      entry.intermediate = false;
+      entry.persistent->store(true);
+    }
+
+    if (entry.pending.valid()) {
+      return entry.pending;
+    }
+    return make_ready(entry.texture);
+  }
 
-  std::shared_ptr<gl::texture> tex;
+
+
+  task next;
+  next.geometry   = geometry;
+  next.brush      = k.brush;
+  next.persistent = std::make_shared<std::atomic<bool>>(!intermediate);
+
+  if (auto base = longest_prefix(geometry, brush)) {
+    next.base              = std::move(base->first);
+    next.base_filter_count = base->second;
+  }
+
+  auto future = next.promise.get_future().share();
+  auto size   = texture_generator::storage_size(geometry, brush);
+
+  cache_.emplace(std::move(k), entry{
+    .pending      = future,
+    .texture      = {},
+    .bytes        = static_cast<size_t>(size.width) * size.height * 4,
+    .last_used    = ++tick_,
+    .intermediate = intermediate,
+    .persistent   = next.persistent
+  });
+
+  {
+    std::lock_guard lock{queue_mutex_};
+    queue_.emplace_back(std::move(next));
+  }
+  queue_cv_.notify_one();
+
+  return future;
+}
+
+
+
+
+
+void texture_provider::worker_loop(const std::stop_token& stoken) {
+  std::optional<texture_generator> generator;
 
   try {
-    if (auto index = best_fit(cache_.keys(), geometry, brush); index < cache_.size()) {
-      tex = std::make_shared<gl::texture>(
-          texture_generator_.generate_from_existing(
-            *cache_.value(index).lock(),
-            geometry,
-            std::span{brush.fgraph->filters}
-              .subspan(cache_.key(index).second.fgraph->filters.size())
-          )
+    generator.emplace(std::make_shared<egl::context>(context_->share()));
+  } catch (std::exception& ex) {
+    logcerr::error("unable to set up texture worker:\n{}", ex.what());
+  }
+
+  std::vector<source_request> sources;
+
+  while (true) {
+    task current;
+
+    {
+      std::unique_lock lock{queue_mutex_};
+      queue_cv_.wait(lock, stoken, [this]() { return !queue_.empty(); });
+
+      // waiting returns whether the queue is non-empty, which stays true after a stop
+      // request as long as textures are queued
+      if (stoken.stop_requested()) {
+        break;
+      }
+
+      current = std::move(queue_.front());
+      queue_.pop_front();
+
+      sources.clear();
+      sources.emplace_back(texture_generator::source_request_for(current.geometry,
+            current.brush));
+      for (const auto& queued: queue_) {
+        sources.emplace_back(texture_generator::source_request_for(queued.geometry,
+              queued.brush));
+      }
+    }
+
+    if (generator) {
+      generator->plan_sources(sources);
+    }
+
+    std::shared_ptr<gl::texture> texture;
+
+    if (generator) {
+      try {
+        texture = process(*generator, current);
+      } catch (std::exception& ex) {
+        logcerr::error("unable to create texture:\n{}", ex.what());
+      }
+    }
+
+    current.promise.set_value(std::move(texture));
+
+    bool idle{false};
+    {
+      std::lock_guard lock{queue_mutex_};
+      idle = queue_.empty();
+    }
+
+    if (idle && generator) {
+      generator->plan_sources({});
+      generator->release_render_targets();
+    }
+  }
+
+
+
+  std::lock_guard lock{queue_mutex_};
+  for (auto& remaining: queue_) {
+    remaining.promise.set_value(nullptr);
+  }
+  queue_.clear();
+}
+
+
+
+std::shared_ptr<gl::texture> texture_provider::process(
+  const texture_generator& generator,
+  const task&              current
+) const {
+  generator.make_context_current();
+
+  std::optional<gl::texture> output;
+
+  if (disk_cache_) {
+    output = disk_cache_->load(current.geometry, current.brush);
+  }
+
+  if (!output) {
+    std::shared_ptr<gl::texture> base;
+    if (current.base) {
+      base = current.base->get();
+    }
+
+    if (base) {
+      output = generator.generate_from_existing(
+          *base,
+          current.geometry,
+          current.brush.fgraph->filters,
+          current.base_filter_count
       );
     } else {
-      tex = std::make_shared<gl::texture>(texture_generator_.generate(geometry, brush));
+      output = generator.generate(current.geometry, current.brush);
     }
-  } catch (std::exception& ex) {
-    logcerr::error("unable to create texture:\n{}", ex.what());
-  }
 
+    if (disk_cache_ && current.persistent->load()) {
+      disk_cache_->store(current.geometry, current.brush, *output);
+    }
+  }
 
-  if (tex) {
-    cache_.emplace(std::make_pair(geometry, brush), tex);
+  gl::fence fence;
+  while (!fence.client_wait(std::chrono::milliseconds{100})) {
+    logcerr::debug("waiting for texture to finish rendering");
   }
 
-  return tex;
+  return std::make_shared<gl::texture>(std::move(*output));
 }
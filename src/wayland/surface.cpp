@@ -196,11 +196,17 @@ void wayland::surface::render() {
   glViewport(0, 0, current_geometry_.physical_size().x(),
       current_geometry_.physical_size().y());
 
+  std::optional<damage_region> damage;
+
   if (render_cb_ && !current_geometry_.empty()) {
-    render_cb_();
+    damage = render_cb_();
   }
 
-  context_->swap_buffers();
+  if (damage) {
+    context_->swap_buffers(damage->rects());
+  } else {
+    context_->swap_buffers();
+  }
 }
 
 
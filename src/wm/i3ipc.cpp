@@ -286,29 +286,41 @@ namespace {
 
 
   void parse_layout(wm::layout_manager& manager, std::string_view json) {
-    rapidjson::Document document;
-    json::assert_parse_success(document.Parse(json.data(), json.size()));
-
-    auto nodes = json::member_to_array(document, "nodes");
-    if (!nodes) {
-      return;
+    for (auto& [name, layout]: wm::parse_layouts(json)) {
+      manager.update_layout(name, std::move(layout));
     }
+  }
+}
 
-    for (const auto& output: *nodes) {
-      if (json::member_to_str(output, "type") != "output") {
-        continue;
-      }
-      if (json::member_to_bool(output, "dpms") != true) {
-        continue;
-      }
 
-      if (auto name = json::member_to_str(output, "name")) {
-        manager.update_layout(*name, parse_output_layout(output));
-      } else {
-        logcerr::warn("found active output without name");
-      }
+
+std::vector<std::pair<std::string, workspace>> wm::parse_layouts(std::string_view json) {
+  rapidjson::Document document;
+  json::assert_parse_success(document.Parse(json.data(), json.size()));
+
+  std::vector<std::pair<std::string, workspace>> layouts;
+
+  auto nodes = json::member_to_array(document, "nodes");
+  if (!nodes) {
+    return layouts;
+  }
+
+  for (const auto& output: *nodes) {
+    if (json::member_to_str(output, "type") != "output") {
+      continue;
+    }
+    if (json::member_to_bool(output, "dpms") != true) {
+      continue;
+    }
+
+    if (auto name = json::member_to_str(output, "name")) {
+      layouts.emplace_back(std::string{*name}, parse_output_layout(output));
+    } else {
+      logcerr::warn("found active output without name");
     }
   }
+
+  return layouts;
 }
 
 
@@ -0,0 +1,140 @@
+#ifndef WALLPABLUR_TESTS_COMMON_HPP_INCLUDED
+#define WALLPABLUR_TESTS_COMMON_HPP_INCLUDED
+
+#include "wallpablur/config/output.hpp"
+#include "wallpablur/image.hpp"
+#include "wallpablur/texture-generator.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <memory>
+#include <span>
+#include <string>
+#include <vector>
+
+#include <vec2.hpp>
+
+
+
+// exit code which makes meson report a test as skipped
+constexpr int test_skipped{77};
+
+
+
+// smooth gradients with some noise and varying alpha, written as farbfeld to the
+// temporary directory and removed again on destruction
+class test_image {
+  public:
+    test_image(const test_image&) = delete;
+    test_image(test_image&&)      = delete;
+    test_image& operator=(const test_image&) = delete;
+    test_image& operator=(test_image&&)      = delete;
+
+    test_image(const std::string& name, vec2<uint32_t> size) :
+      path_{std::filesystem::temp_directory_path() / (name + ".ff")}
+    {
+      auto stride = static_cast<size_t>(size.x()) * 4;
+      auto pixels = std::make_shared<std::vector<std::byte>>(stride * size.y());
+
+      uint32_t state{0x12345678};
+
+      for (uint32_t y = 0; y < size.y(); ++y) {
+        for (uint32_t x = 0; x < size.x(); ++x) {
+          state = state * 1664525u + 1013904223u;
+          auto noise = (state >> 24u) & 0x1fu;
+
+          auto* pixel = pixels->data() + y * stride + x * 4;
+          pixel[0] = static_cast<std::byte>(x * 255 / size.x() ^ noise);
+          pixel[1] = static_cast<std::byte>(y * 255 / size.y() ^ noise);
+          pixel[2] = static_cast<std::byte>((x + y) % 256);
+          pixel[3] = static_cast<std::byte>(255 - (x * 127 / size.x()));
+        }
+      }
+
+      write_farbfeld(path_, image{
+        .width   = static_cast<GLsizei>(size.x()),
+        .height  = static_cast<GLsizei>(size.y()),
+        .stride  = stride,
+        .format  = gl::texture::format::rgba8,
+        .pixels  = *pixels,
+        .storage = pixels,
+
+        .original_size = size
+      });
+    }
+
+    ~test_image() {
+      std::error_code ec;
+      std::filesystem::remove(path_, ec);
+    }
+
+
+
+    [[nodiscard]] config::brush brush(
+        std::vector<config::filter> filters,
+        config::image_distribution  distribution = {}
+    ) const {
+      config::brush output;
+      output.solid  = {0.2f, 0.4f, 0.6f, 1.f};
+      output.fgraph = config::filter_graph{
+        .path         = path_,
+        .distribution = distribution,
+        .filters      = std::move(filters)
+      };
+      return output;
+    }
+
+
+
+  private:
+    std::filesystem::path path_;
+};
+
+
+
+[[nodiscard]] inline config::box_blur_filter box_blur(
+    vec2<uint32_t> size,
+    unsigned int   iterations,
+    float          dithering
+) {
+  config::box_blur_filter filter;
+  filter.size       = size;
+  filter.iterations = iterations;
+  filter.dithering  = dithering;
+  return filter;
+}
+
+
+
+[[nodiscard]] inline std::vector<std::byte> render(
+    const texture_generator& generator,
+    vec2<uint32_t>           size,
+    const config::brush&     brush
+) {
+  wayland::geometry geometry;
+  geometry.physical_size(size);
+
+  return generator.generate(geometry, brush).download();
+}
+
+
+
+// largest difference of any channel, 256 if the sizes do not match
+[[nodiscard]] inline int max_difference(
+    std::span<const std::byte> lhs,
+    std::span<const std::byte> rhs
+) {
+  if (lhs.size() != rhs.size()) {
+    return 256;
+  }
+
+  int output{0};
+  for (size_t i = 0; i < lhs.size(); ++i) {
+    output = std::max(output, std::abs(static_cast<int>(lhs[i]) - static_cast<int>(rhs[i])));
+  }
+  return output;
+}
+
+#endif // WALLPABLUR_TESTS_COMMON_HPP_INCLUDED
@@ -0,0 +1,116 @@
+#include "common.hpp"
+
+#include "wallpablur/config/config.hpp"
+#include "wallpablur/egl/context.hpp"
+
+#include <array>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string_view>
+
+#include <logcerr/log.hpp>
+
+
+
+namespace {
+  // rounding differs between GPU sampling and blending and the CPU emulation of it
+  constexpr int tolerance{2};
+
+
+
+  struct distribution_case {
+    std::string_view           name;
+    config::image_distribution distribution;
+  };
+
+  [[nodiscard]] std::vector<distribution_case> distribution_cases() {
+    using enum config::scale_mode;
+    using enum config::wrap_mode;
+
+    return {
+      {"fit",              {.scale = fit}},
+      {"zoom",             {.scale = zoom}},
+      {"stretch",          {.scale = stretch}},
+      {"centered",         {.scale = centered}},
+      {"centered-tiled",   {.scale = centered, .wrap_x = tiled, .wrap_y = tiled_mirror}},
+      {"fit-stretch-edge", {.scale = fit, .wrap_x = stretch_edge, .wrap_y = stretch_edge}},
+      {"zoom-nearest",     {.scale = zoom, .filter = config::scale_filter::nearest}},
+    };
+  }
+
+
+
+  struct filter_case {
+    std::string_view            name;
+    std::vector<config::filter> filters;
+  };
+
+  [[nodiscard]] std::vector<filter_case> filter_cases() {
+    return {
+      {"rescale",          {}},
+      {"invert",           {config::invert_filter{}}},
+      {"box-blur",         {box_blur({6, 4}, 2, 0.f)}},
+      {"box-blur-dither",  {box_blur({24, 24}, 1, 1.f)}},
+      {"box-blur+invert",  {box_blur({8, 8}, 2, 1.f), config::invert_filter{}}},
+    };
+  }
+
+
+
+  constexpr std::array output_sizes {
+    vec2<uint32_t>{160,  90},
+    vec2<uint32_t>{ 90, 160},
+  };
+
+
+
+  [[nodiscard]] std::vector<std::byte> render_with(
+      config::filter_backend   backend,
+      const texture_generator& generator,
+      vec2<uint32_t>           size,
+      const config::brush&     brush
+  ) {
+    config::global_config().filter_backend(backend);
+    return render(generator, size, brush);
+  }
+}
+
+
+
+int main() {
+  try {
+    logcerr::output_level(logcerr::severity::warning);
+
+    auto context = std::make_shared<egl::context>(egl::context::headless(1, 1));
+    context->make_current();
+
+    texture_generator generator{context};
+    test_image source{"wallpablur-test-cpu-filter", {301, 173}};
+
+    int failures{0};
+
+    for (auto size: output_sizes) {
+      for (const auto& distribution: distribution_cases()) {
+        for (const auto& filter: filter_cases()) {
+          auto brush = source.brush(filter.filters, distribution.distribution);
+
+          auto difference = max_difference(
+              render_with(config::filter_backend::cpu, generator, size, brush),
+              render_with(config::filter_backend::gl,  generator, size, brush));
+
+          std::cout << logcerr::format("{:#} {} {}: max difference {}\n",
+              size, distribution.name, filter.name, difference);
+
+          failures += difference > tolerance ? 1 : 0;
+        }
+      }
+    }
+
+    return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+
+  } catch (std::exception& ex) {
+    logcerr::error(ex.what());
+    return EXIT_FAILURE;
+  }
+}
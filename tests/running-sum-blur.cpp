@@ -0,0 +1,85 @@
+#include "common.hpp"
+
+#include "wallpablur/egl/context.hpp"
+
+#include <array>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+
+#include <logcerr/log.hpp>
+
+
+
+namespace {
+  struct blur_case {
+    vec2<uint32_t> output;
+    vec2<uint32_t> size;
+    unsigned int   iterations;
+    float          dithering;
+  };
+
+  // covers the threshold, mixed paths per direction, lines split into several segments
+  // and radii exceeding the image
+  constexpr std::array blur_cases {
+    blur_case{{160,  90}, {16,  16}, 1, 0.f},
+    blur_case{{160,  90}, {16,   8}, 2, 1.f},
+    blur_case{{ 97, 131}, {40,  24}, 3, 1.f},
+    blur_case{{640, 360}, {20,  20}, 2, 0.f},
+    blur_case{{640, 360}, {20,  20}, 1, 1.f},
+    blur_case{{160,  90}, {200, 120}, 2, 0.f},
+    blur_case{{ 64,  64}, {96,  96}, 2, 1.f},
+  };
+
+
+
+  // both paths sum up the same 8 bit values, but seed the dithering noise from slightly
+  // different coordinates
+  [[nodiscard]] int tolerance(const blur_case& test) {
+    return test.dithering > 0.f ? 2 : 0;
+  }
+}
+
+
+
+int main() {
+  try {
+    logcerr::output_level(logcerr::severity::warning);
+
+    auto context = std::make_shared<egl::context>(egl::context::headless(1, 1));
+    context->make_current();
+
+    if (epoxy_gl_version() < 43) {
+      logcerr::warn("the running sum needs OpenGL 4.3, skipping");
+      return test_skipped;
+    }
+
+    texture_generator generator{context};
+    test_image source{"wallpablur-test-running-sum", {301, 173}};
+
+    int failures{0};
+
+    for (const auto& test: blur_cases) {
+      auto brush = source.brush({box_blur(test.size, test.iterations, test.dithering)});
+
+      generator.use_running_sum(true);
+      auto running_sum = render(generator, test.output, brush);
+
+      generator.use_running_sum(false);
+      auto line_blur = render(generator, test.output, brush);
+
+      auto difference = max_difference(running_sum, line_blur);
+
+      std::cout << logcerr::format("{:#} blur {:#}x{} dithering {}: max difference {}\n",
+          test.output, test.size, test.iterations, test.dithering, difference);
+
+      failures += difference > tolerance(test) ? 1 : 0;
+    }
+
+    return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+
+  } catch (std::exception& ex) {
+    logcerr::error(ex.what());
+    return EXIT_FAILURE;
+  }
+}
@@ -0,0 +1,114 @@
+#include "common.hpp"
+
+#include "wallpablur/config/config.hpp"
+#include "wallpablur/egl/context.hpp"
+
+#include <array>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string_view>
+
+#include <logcerr/log.hpp>
+
+
+
+namespace {
+  struct prefix_case {
+    std::string_view            name;
+    config::filter_backend      backend;
+    std::vector<config::filter> filters;
+    size_t                      prefix_length;
+  };
+
+  [[nodiscard]] std::vector<prefix_case> prefix_cases() {
+    using enum config::filter_backend;
+
+    config::gaussian_blur_filter gaussian;
+    gaussian.size = {60, 60};
+
+    config::kawase_blur_filter kawase;
+    kawase.radius = 60;
+
+    return {
+      {"reduced prefix + invert",       gl,  {gaussian, config::invert_filter{}},  1},
+      {"reduced prefix + small blur",   gl,  {gaussian, box_blur({2, 2}, 1, 0.f)}, 1},
+      {"small prefix + reduced blur",   gl,  {box_blur({2, 2}, 1, 0.f), kawase,
+                                              config::invert_filter{}},            1},
+      {"cpu prefix + reduced blur",     cpu, {box_blur({30, 30}, 2, 0.f), gaussian,
+                                              config::invert_filter{}},            0},
+      {"cpu prefix + invert",           cpu, {box_blur({30, 30}, 2, 0.f),
+                                              config::invert_filter{}},            0},
+    };
+  }
+
+
+
+  constexpr std::array output_sizes {
+    vec2<uint32_t>{640, 360},
+    vec2<uint32_t>{333, 555},
+  };
+
+
+
+  [[nodiscard]] gl::texture_size size_of(const gl::texture& texture) {
+    texture.bind();
+    return gl::active_texture_size();
+  }
+}
+
+
+
+int main() {
+  try {
+    logcerr::output_level(logcerr::severity::warning);
+
+    auto context = std::make_shared<egl::context>(egl::context::headless(1, 1));
+    context->make_current();
+
+    texture_generator generator{context};
+    test_image source{"wallpablur-test-storage-size", {301, 173}};
+
+    int failures{0};
+
+    for (auto output: output_sizes) {
+      wayland::geometry geometry;
+      geometry.physical_size(output);
+
+      for (const auto& test: prefix_cases()) {
+        config::global_config().filter_backend(test.backend);
+
+        auto brush = source.brush(test.filters);
+
+        // the cpu backend continues on the gpu by itself, from the filters it supports
+        auto texture = [&]() {
+          if (test.prefix_length == 0) {
+            return generator.generate(geometry, brush);
+          }
+
+          auto prefix = source.brush({test.filters.begin(),
+                                      test.filters.begin() + test.prefix_length});
+          auto base   = generator.generate(geometry, prefix);
+
+          return generator.generate_from_existing(base, geometry, test.filters,
+              test.prefix_length);
+        }();
+
+        auto stored   = size_of(texture);
+        auto expected = texture_generator::storage_size(geometry, brush);
+
+        std::cout << logcerr::format("{:#} {}: stored {}x{}, expected {}x{}\n",
+            output, test.name, stored.width, stored.height, expected.width, expected.height);
+
+        failures += stored.width != expected.width || stored.height != expected.height
+                    ? 1 : 0;
+      }
+    }
+
+    return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+
+  } catch (std::exception& ex) {
+    logcerr::error(ex.what());
+    return EXIT_FAILURE;
+  }
+}